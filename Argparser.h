@@ -24,6 +24,12 @@
  */
 #pragma once
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 //******************************************************************************
 // Type definitions
@@ -32,16 +38,50 @@
  * Argparser context: Should be created by calling `Argparser_new()`.
  */
 typedef struct Argparser Argparser;
+/**
+ * Compiled option definitions: Created by `Argparser_init()` and read-only afterwards.
+ * A schema can be shared by many parse contexts, also across threads.
+ */
+typedef struct ArgparserSchema ArgparserSchema;
 /**
  * An option: Should be created using macros, e.g. ARGPARSER_OPT_BOOL(...).
  */
 typedef struct ArgparserOption ArgparserOption;
+/**
+ * A subcommand with its own options: Should be created using ARGPARSER_COMMAND(...).
+ */
+typedef struct ArgparserCommand ArgparserCommand;
+/**
+ * A rule between options, checked after parsing: Should be created using macros, e.g. ARGPARSER_REQUIRED(...).
+ */
+typedef struct ArgparserConstraint ArgparserConstraint;
+/**
+ * Description of a parsing error, filled by `Argparser_tryParse()`.
+ */
+typedef struct ArgparserError ArgparserError;
+/**
+ * One argument vector for `Argparser_parseBatch()`.
+ */
+typedef struct ArgparserBatchEntry ArgparserBatchEntry;
+/**
+ * Values of a list option, e.g. ARGPARSER_OPT_STRING_LIST(...).
+ * Should be zero-initialized; the items are owned by the Argparser context.
+ */
+typedef struct ArgparserList ArgparserList;
+/**
+ * Usage and timing statistics of a context, see `Argparser_getStats()`.
+ */
+typedef struct ArgparserStats ArgparserStats;
 /**
  * Callback-method definition used in ArgparserOption.
  * The callback is called after an ArgparserOption value is set.
  * Callbacks should be passed to macros, e.g. ARGPARSER_OPT_BOOL_CALLBACK(...).
  */
 typedef void Argparser_callback(Argparser* self, const ArgparserOption* option);
+/**
+ * Callback-method definition for arguments that are no options, used by `Argparser_parseStream()`.
+ */
+typedef void Argparser_argumentCallback(Argparser* self, const char* argument);
 
 
 //******************************************************************************
@@ -53,6 +93,7 @@ typedef void Argparser_callback(Argparser* self, const ArgparserOption* option);
 Argparser* Argparser_new();
 /**
  * Initializes Argparser with the given options.
+ * Builds the lookup indices for short and long option names; exits if a name is used twice.
  * @options:
  *      Array with all options. Options should be created using the macros below.
  */
@@ -78,15 +119,254 @@ void Argparser_setEpilog(Argparser* self, const char* epilog);
  *            Hence, it does not parse `--opt2` and returns it in `argv`.
  */
 void Argparser_setStopAtNonOption(Argparser* self, bool stop);
+/**
+ * Declares that the option values are members of the struct `outputTemplate`.
+ * Parse contexts can then redirect the values into other instances of this struct,
+ * see `Argparser_setOutput()`. Values outside of the template are written as usual.
+ * @size:
+ *      Size of the struct, e.g. `sizeof(*outputTemplate)`.
+ */
+void Argparser_setOutputTemplate(Argparser* self, const void* outputTemplate, size_t size);
+/**
+ * Enables response files: An argument `@file` is replaced by the arguments stored in `file`.
+ * The file is split like a shell command line (see `Argparser_tokenize()`) and may include further response files.
+ * Files are memory-mapped and split in place; their arguments stay valid until the next parse or `Argparser_clear()`.
+ * Unreadable files are kept as arguments, arguments after `--` are not expanded.
+ * @enable:
+ *      false: `@file` is a regular argument (default).
+ *      true: `@file` is expanded. Afterwards, use `Argparser_getArguments()` to access the remaining arguments.
+ */
+void Argparser_setResponseFiles(Argparser* self, bool enable);
+/**
+ * Registers subcommands like `git commit` or `git push`, each with its own options and help.
+ * The options of this Argparser are parsed up to the first non-option, which selects the command;
+ * the following arguments are parsed with the options of the command.
+ * Only the selected command is indexed and checked for duplicate names, on its first use,
+ * so the startup time does not grow with the options of the other commands.
+ * `Argparser_getSchema()` compiles the remaining commands before the schema is shared.
+ * The help message lists the commands, `-h` after a command shows the help of the command.
+ * @commands:
+ *      Array terminated by ARGPARSER_COMMAND_END(), has to stay valid as long as the Argparser.
+ */
+void Argparser_setCommands(Argparser* self, const ArgparserCommand* commands);
+/**
+ * Allows abbreviated long options, e.g. `--num` for `--number`.
+ * Exact names always take precedence. A prefix of several names is rejected as ambiguous
+ * and the error lists the candidates. The prefixes are resolved with a radix trie of the long names,
+ * which is built here, so this should be called after `Argparser_init()` and before sharing the schema.
+ * @allow:
+ *      false: long options must match exactly (default).
+ *      true: unique prefixes of long options are accepted, also by subcommands.
+ */
+void Argparser_setAllowAbbreviations(Argparser* self, bool allow);
+/**
+ * Enables the hidden completion mode for shells. `Argparser_parse()` then answers
+ *      program --__complete <word>... <partial>
+ * by printing the options and commands starting with `partial`, one per line, and exits.
+ * The preceding words select the subcommand. The answer is looked up in the radix trie
+ * of the long names, so it should be parsed before any expensive initialization.
+ *      program --__completion-script <bash|zsh|fish>
+ * prints the script that connects the shell to this mode, see `Argparser_writeCompletionScript()`.
+ * `Argparser_tryParse()` ignores both arguments.
+ */
+void Argparser_setCompletion(Argparser* self, bool enable);
+/**
+ * Declares rules between the options, which are checked after all arguments are parsed.
+ * Options are named like on the command line and separated by spaces, e.g. "--json --yaml -x".
+ * Given options are recorded in a bitset, so the rules are checked in one pass over their options.
+ * Violations are reported like other errors, with code ARGPARSER_ERROR_CONSTRAINT and index -1,
+ * or ARGPARSER_ERROR_INVALID_VALUE for values out of range. Options of subcommands are not covered.
+ * @constraints:
+ *      Array terminated by ARGPARSER_CONSTRAINT_END(); exits if it names an unknown option.
+ */
+void Argparser_setConstraints(Argparser* self, const ArgparserConstraint* constraints);
+/**
+ * Reads option values from a config file during each following parse, after the command line.
+ * Options given on the command line take precedence, the file only sets the others.
+ * Lines have the form `key = value`, where `key` is the long name of an option. Lines starting
+ * with `#` or `;` are comments, and `[section]` prefixes the following keys with `section-`.
+ * Values may be quoted; booleans also accept true/false, yes/no, and on/off.
+ * The file is memory-mapped and split in place in a single pass. String values are copied out
+ * of it, one buffer per option, as the next parse unmaps the file; they stay valid until the
+ * option is read again or `Argparser_clear()`. Errors, including violated ranges, report the file
+ * and line.
+ * @path:
+ *      Path of the file, which has to exist, or NULL to read no file (default).
+ */
+void Argparser_setConfigFile(Argparser* self, const char* path);
+/**
+ * Derives environment variables from the long names, which are read during each following parse
+ * for options that are absent from the command line. The variable of `--dry-run` with prefix "APP_"
+ * is APP_DRY_RUN. Options with the `env` field name their variable themselves, also without a prefix,
+ * and options without a value, e.g. help, are skipped. Values are converted like on the command line,
+ * booleans also accept true/false, yes/no, and on/off. The precedence is command line, environment,
+ * config file. The environment is scanned once per parse into a hash index, so the cost does not
+ * grow with options times variables like calls of `getenv()` would.
+ * Only the options given to `Argparser_init()` are read, not those of subcommands.
+ * @prefix:
+ *      Prefix of the derived names, or NULL to only read the `env` fields (default).
+ */
+void Argparser_setEnvPrefix(Argparser* self, const char* prefix);
+/**
+ * Returns the compiled schema of an initialized Argparser, including its rendered help message
+ * and the options of all commands. Once the schema is shared, the setters above must not be called anymore.
+ */
+const ArgparserSchema* Argparser_getSchema(const Argparser* self);
+/**
+ * Initializes a lightweight parse context for a shared schema.
+ * The context can live on the stack and does not allocate or copy the schema.
+ * Each thread uses its own context, the schema is only read during parsing.
+ */
+void Argparser_initWithSchema(Argparser* self, const ArgparserSchema* schema);
+/**
+ * Writes the values of the following parses into `output` instead of the output template.
+ * @output:
+ *      Struct of the type given to `Argparser_setOutputTemplate()`, or NULL to reset.
+ */
+void Argparser_setOutput(Argparser* self, void* output);
+/**
+ * Returns the address the value of the given option is written to.
+ * Callbacks should use it instead of `option->value` if outputs are redirected.
+ */
+void* Argparser_getValue(const Argparser* self, const ArgparserOption* option);
+/**
+ * Leaves `argv` untouched in the following parses, e.g. to replay recorded command lines.
+ * Instead of moving the remaining arguments to the front of `argv`, their positions in
+ * `Argparser_getArguments()` are written to `positions` in order. That vector is `argv` itself
+ * unless response files were expanded. Parses still return the number of remaining arguments.
+ * @positions:
+ *      Buffer for up to `capacity` positions, or NULL to collect the arguments in `argv` (default).
+ *      Positions beyond the capacity are counted but not written.
+ */
+void Argparser_setPositionOutput(Argparser* self, int* positions, int capacity);
 /**
  * Parses the given command line arguments.
  * @return:
  *      Remaining amount of arguments in `argv`, usually set to `argc`.
  */
 int Argparser_parse(Argparser* self, int argc, const char **argv);
+/**
+ * Returns the remaining arguments of the last parse.
+ * This is `argv` unless response files were expanded into a larger argument vector.
+ */
+const char** Argparser_getArguments(const Argparser* self);
+/**
+ * Returns the command selected by the last parse, see `Argparser_setCommands()`.
+ * Its name is not part of the remaining arguments.
+ * @return:
+ *      The command, or NULL if no command was given.
+ */
+const ArgparserCommand* Argparser_getCommand(const Argparser* self);
+/**
+ * Prepares the context for the next parse, unlike `Argparser_clear()` the context stays usable.
+ * The lists filled since the last reset are emptied and the arena of their values is rewound.
+ * The newest arena block, which is the largest, is kept for the next parse and the older ones
+ * are freed. The cost grows with the number of list options and freed blocks, so once the
+ * arena stopped growing, a reset empties the lists and rewinds one block without allocating.
+ */
+void Argparser_reset(Argparser* self);
+/**
+ * Parses the given command line arguments without exiting the program on errors.
+ * Errors, including errors raised by callbacks, are reported in `error` instead.
+ * A help request returns ARGPARSER_ERROR_HELP without printing anything.
+ * Parsing does not allocate memory, making it suitable for long-running servers.
+ * @error:
+ *      Receives the error. Its `message` buffer is provided by the caller and may be NULL.
+ * @return:
+ *      Remaining amount of arguments in `argv`, or -1 on errors.
+ *      After an error, the order of the arguments in `argv` is unspecified.
+ */
+int Argparser_tryParse(Argparser* self, int argc, const char **argv, ArgparserError* error);
+/**
+ * Splits a command line into arguments like a POSIX shell, e.g. to parse commands received as strings.
+ * Whitespace separates arguments, single quotes keep their content literally,
+ * double quotes only treat \\, \", \$, and \` as escapes, and a backslash outside of quotes escapes any character.
+ * The arguments are unquoted into `arena` without allocating memory; `argv` points into it.
+ * Since the first argument is treated as program name, `argv` can be passed to `Argparser_parse()`.
+ * @arena:
+ *      Buffer with at least `length + 1` bytes. It may be `input` itself to tokenize in place.
+ * @argv:
+ *      Receives up to `maxArgs` arguments, followed by NULL if there is space left.
+ * @return:
+ *      Amount of arguments, which may exceed `maxArgs` if `argv` is too small,
+ *      or -1 if a quote is not closed or the input ends with a backslash.
+ */
+int Argparser_tokenize(const char* input, size_t length, char* arena, const char** argv, int maxArgs);
+/**
+ * Parses NUL-delimited arguments read from a file descriptor, e.g. the output of `find -print0`.
+ * Options are applied as they appear. Other arguments are passed to `callback` instead of being
+ * collected, and are only valid during the call. The input is read in chunks, so memory use is
+ * bounded by `chunkSize` regardless of the input length. String values are copied and stay valid
+ * until the next parse or `Argparser_clear()`.
+ * @chunkSize:
+ *      Size of the read buffer, 0 uses 64 KiB. Each argument, together with its value, has to fit into it.
+ * @error:
+ *      NULL to exit on errors as `Argparser_parse()`, otherwise errors are reported as by `Argparser_tryParse()`.
+ * @return:
+ *      Amount of arguments passed to `callback`, or -1 on errors.
+ */
+long Argparser_parseStream(Argparser* self, int fd, Argparser_argumentCallback* callback,
+    size_t chunkSize, ArgparserError* error);
+#ifdef ARGPARSER_ENABLE_THREADS
+/**
+ * Parses many argument vectors against one schema using a pool of threads.
+ * Each entry is parsed as by `Argparser_tryParse()`, its values are written into `entry->output`.
+ * The output is initialized with the output template first, see `Argparser_setOutputTemplate()`.
+ * Threads steal work from each other, so uneven entries do not stall the pool.
+ * Callbacks are called concurrently and have to be thread-safe.
+ * List options and response files are not supported, since their memory belongs to the workers.
+ * Requires `#define ARGPARSER_ENABLE_THREADS` and linking with pthreads.
+ * @threads:
+ *      Amount of threads including the calling one, 0 uses one per online processor.
+ * @return:
+ *      Amount of entries that failed to parse.
+ */
+size_t Argparser_parseBatch(const ArgparserSchema* schema, ArgparserBatchEntry* entries, size_t count, int threads);
+#endif
+#ifdef ARGPARSER_ENABLE_STATS
+/**
+ * Returns the statistics of this context, accumulated over all parses since the last reset.
+ * Counts how often each option was given and measures the time spent in parsing, option lookup,
+ * value conversion, and callbacks. The per-option counters are allocated by the first parse.
+ * Requires `#define ARGPARSER_ENABLE_STATS` in every translation unit including Argparser.h;
+ * without it, no statistics are collected and parsing has no overhead.
+ */
+const ArgparserStats* Argparser_getStats(const Argparser* self);
+/**
+ * Sets all statistics to zero.
+ */
+void Argparser_resetStats(Argparser* self);
+/**
+ * Writes the statistics to a file descriptor, e.g. 2 for stderr.
+ * @json:
+ *      false: Writes a table for humans.
+ *      true: Writes a single JSON object.
+ */
+void Argparser_dumpStats(const Argparser* self, int fd, bool json);
+#endif
+/**
+ * Writes a completion script for `bash`, `zsh`, or `fish` that asks `program --__complete` for candidates.
+ * Files are completed if the program has no candidates. See `Argparser_setCompletion()`.
+ * @return:
+ *      false if the shell is not supported.
+ */
+bool Argparser_writeCompletionScript(const char* program, const char* shell, int fd);
+/**
+ * Locale-independent conversions used for option values, e.g. within callbacks.
+ * The complete text has to be a number. Integers accept the prefixes `0x` (hexadecimal)
+ * and `0` (octal) like `strtol`. Sizes accept the suffixes K, M, G, T, P (powers of 1000)
+ * and Ki, Mi, Gi, Ti, Pi (powers of 1024), optionally followed by B, e.g. `64Ki` or `2GB`.
+ * @return:
+ *      NULL on success, otherwise the reason why the text was rejected.
+ */
+const char* Argparser_toInt64(const char* text, int64_t* value);
+const char* Argparser_toUint64(const char* text, uint64_t* value);
+const char* Argparser_toDouble(const char* text, double* value);
+const char* Argparser_toSize(const char* text, size_t* value);
 /**
  * Default error-handler for parsing errors, exits program when called.
  * Should be called from callbacks if parsing errors occurs, e.g. if value is out-of-range.
+ * Within `Argparser_tryParse()`, it aborts parsing and reports the error instead.
  */
 void Argparser_exitDueToError(Argparser* self, const ArgparserOption* option, const char* reason);
 /**
@@ -107,6 +387,14 @@ void Argparser_delete(Argparser* self);
 #define ARGPARSER_OPT_BOOL_CALLBACK(shortName, longName, valuePtr, description, callback) \
     { ARGPARSER_TYPE_BOOLEAN, shortName, longName, valuePtr, description, callback }
 
+// Boolean stored as bit `bit` of the uint64_t array `maskPtr`, bit 64 is bit 0 of `maskPtr[1]`
+#define ARGPARSER_OPT_FLAG(shortName, longName, maskPtr, bit, description) \
+    { ARGPARSER_TYPE_FLAG, shortName, longName, maskPtr, description, NULL, bit }
+#define ARGPARSER_OPT_FLAG_CALLBACK(shortName, longName, maskPtr, bit, description, callback) \
+    { ARGPARSER_TYPE_FLAG, shortName, longName, maskPtr, description, callback, bit }
+// Mask of a flag within its uint64_t, e.g. `flags[0] & (ARGPARSER_FLAG_MASK(A) | ARGPARSER_FLAG_MASK(B))`
+#define ARGPARSER_FLAG_MASK(bit)    ((uint64_t)1 << ((bit) % 64))
+
 #define ARGPARSER_OPT_INT(shortName, longName, valuePtr, description) \
     { ARGPARSER_TYPE_INTEGER, shortName, longName, valuePtr, description }
 #define ARGPARSER_OPT_INT_CALLBACK(shortName, longName, valuePtr, description, callback) \
@@ -117,14 +405,68 @@ void Argparser_delete(Argparser* self);
 #define ARGPARSER_OPT_FLOAT_CALLBACK(shortName, longName, valuePtr, description, callback) \
     { ARGPARSER_TYPE_FLOAT, shortName, longName, valuePtr, description, callback }
 
+#define ARGPARSER_OPT_INT64(shortName, longName, valuePtr, description) \
+    { ARGPARSER_TYPE_INT64, shortName, longName, valuePtr, description }
+#define ARGPARSER_OPT_INT64_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    { ARGPARSER_TYPE_INT64, shortName, longName, valuePtr, description, callback }
+
+#define ARGPARSER_OPT_UINT64(shortName, longName, valuePtr, description) \
+    { ARGPARSER_TYPE_UINT64, shortName, longName, valuePtr, description }
+#define ARGPARSER_OPT_UINT64_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    { ARGPARSER_TYPE_UINT64, shortName, longName, valuePtr, description, callback }
+
+#define ARGPARSER_OPT_DOUBLE(shortName, longName, valuePtr, description) \
+    { ARGPARSER_TYPE_DOUBLE, shortName, longName, valuePtr, description }
+#define ARGPARSER_OPT_DOUBLE_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    { ARGPARSER_TYPE_DOUBLE, shortName, longName, valuePtr, description, callback }
+
+#define ARGPARSER_OPT_SIZE(shortName, longName, valuePtr, description) \
+    { ARGPARSER_TYPE_SIZE, shortName, longName, valuePtr, description }
+#define ARGPARSER_OPT_SIZE_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    { ARGPARSER_TYPE_SIZE, shortName, longName, valuePtr, description, callback }
+
 #define ARGPARSER_OPT_STRING(shortName, longName, valuePtr, description) \
     { ARGPARSER_TYPE_STRING, shortName, longName, valuePtr, description }
 #define ARGPARSER_OPT_STRING_CALLBACK(shortName, longName, valuePtr, description, callback) \
     { ARGPARSER_TYPE_STRING, shortName, longName, valuePtr, description, callback }
 
+// Stores the position of the value in `choices`, a NULL-terminated array of strings, as int
+#define ARGPARSER_OPT_CHOICE(shortName, longName, valuePtr, choices, description) \
+    { ARGPARSER_TYPE_CHOICE, shortName, longName, valuePtr, description, NULL, 0, NULL, choices }
+#define ARGPARSER_OPT_CHOICE_CALLBACK(shortName, longName, valuePtr, choices, description, callback) \
+    { ARGPARSER_TYPE_CHOICE, shortName, longName, valuePtr, description, callback, 0, NULL, choices }
+
+#define ARGPARSER_OPT_STRING_LIST(shortName, longName, listPtr, description) \
+    { ARGPARSER_TYPE_STRING_LIST, shortName, longName, listPtr, description }
+#define ARGPARSER_OPT_STRING_LIST_CALLBACK(shortName, longName, listPtr, description, callback) \
+    { ARGPARSER_TYPE_STRING_LIST, shortName, longName, listPtr, description, callback }
+
+#define ARGPARSER_OPT_INT_LIST(shortName, longName, listPtr, description) \
+    { ARGPARSER_TYPE_INTEGER_LIST, shortName, longName, listPtr, description }
+#define ARGPARSER_OPT_INT_LIST_CALLBACK(shortName, longName, listPtr, description, callback) \
+    { ARGPARSER_TYPE_INTEGER_LIST, shortName, longName, listPtr, description, callback }
+
+#define ARGPARSER_OPT_FLOAT_LIST(shortName, longName, listPtr, description) \
+    { ARGPARSER_TYPE_FLOAT_LIST, shortName, longName, listPtr, description }
+#define ARGPARSER_OPT_FLOAT_LIST_CALLBACK(shortName, longName, listPtr, description, callback) \
+    { ARGPARSER_TYPE_FLOAT_LIST, shortName, longName, listPtr, description, callback }
+
 #define ARGPARSER_OPT_GROUP(description)     { ARGPARSER_TYPE_GROUP, 0, NULL, NULL, description, NULL }
 #define ARGPARSER_OPT_END()                  { ARGPARSER_TYPE_END, 0, NULL, NULL, 0, NULL }
 
+// Each of the options has to be given
+#define ARGPARSER_REQUIRED(options)             { ARGPARSER_CONSTRAINT_REQUIRED, options, NULL, 0, 0 }
+// At most one of the options may be given
+#define ARGPARSER_EXCLUSIVE(options)            { ARGPARSER_CONSTRAINT_EXCLUSIVE, options, NULL, 0, 0 }
+// If one of the options is given, all of the `required` ones have to be given too
+#define ARGPARSER_REQUIRES(options, required)   { ARGPARSER_CONSTRAINT_REQUIRES, options, required, 0, 0 }
+// Given numbers, including the items of lists, have to be within [min, max]
+#define ARGPARSER_RANGE(options, min, max)      { ARGPARSER_CONSTRAINT_RANGE, options, NULL, min, max }
+#define ARGPARSER_CONSTRAINT_END()              { ARGPARSER_CONSTRAINT_END, NULL, NULL, 0, 0 }
+
+#define ARGPARSER_COMMAND(name, options, help)  { name, options, help }
+#define ARGPARSER_COMMAND_END()                 { NULL, NULL, NULL }
+
 void Argparser_exitForHelp(Argparser* self, const ArgparserOption* option);
 #define ARGPARSER_OPT_HELP()       \
     ARGPARSER_OPT_BOOL_CALLBACK('h', "help", NULL, "show this help message and exit", Argparser_exitForHelp)
@@ -143,8 +485,29 @@ enum ArgparserOptionType
     ARGPARSER_TYPE_INTEGER,
     ARGPARSER_TYPE_FLOAT,
     ARGPARSER_TYPE_STRING,
+    ARGPARSER_TYPE_INT64,           // int64_t
+    ARGPARSER_TYPE_UINT64,          // uint64_t
+    ARGPARSER_TYPE_DOUBLE,          // double
+    ARGPARSER_TYPE_SIZE,            // size_t, accepts unit suffixes
+    ARGPARSER_TYPE_STRING_LIST,     // ArgparserList of const char*
+    ARGPARSER_TYPE_INTEGER_LIST,    // ArgparserList of int
+    ARGPARSER_TYPE_FLOAT_LIST,      // ArgparserList of float
+    ARGPARSER_TYPE_FLAG,            // Bit in an array of uint64_t
+    ARGPARSER_TYPE_CHOICE,          // int, position of the value in the choices
 };
 
+typedef struct ArgparserList
+{
+    int count;
+    int capacity;
+    union {
+        const char **strings;
+        int *ints;
+        float *floats;
+        void *items;
+    };
+} ArgparserList;
+
 typedef struct ArgparserOption
 {
     enum ArgparserOptionType type;
@@ -153,23 +516,208 @@ typedef struct ArgparserOption
     void *value;
     const char *help;
     Argparser_callback *callback;
+    unsigned bit;                   // Position of ARGPARSER_TYPE_FLAG options in their mask
+    const char *env;                // Environment variable read when the option is absent, see Argparser_setEnvPrefix
+    const char *const *choices;     // NULL-terminated values of ARGPARSER_TYPE_CHOICE options
 } ArgparserOption;
 
-typedef struct Argparser
+typedef struct ArgparserCommand
+{
+    const char *name;
+    ArgparserOption *options;
+    const char *help;               // Listed with the commands and shown above their options
+} ArgparserCommand;
+
+enum ArgparserErrorCode
+{
+    ARGPARSER_OK,
+    ARGPARSER_ERROR_UNKNOWN_OPTION,
+    ARGPARSER_ERROR_INVALID_VALUE,
+    ARGPARSER_ERROR_HELP,
+    ARGPARSER_ERROR_RESPONSE_FILE,
+    ARGPARSER_ERROR_STREAM,
+    ARGPARSER_ERROR_UNKNOWN_COMMAND,
+    ARGPARSER_ERROR_AMBIGUOUS_OPTION,
+    ARGPARSER_ERROR_CONSTRAINT,
+    ARGPARSER_ERROR_CONFIG,
+    ARGPARSER_ERROR_MEMORY,
+};
+
+enum ArgparserConstraintType
+{
+    ARGPARSER_CONSTRAINT_END,
+    ARGPARSER_CONSTRAINT_REQUIRED,
+    ARGPARSER_CONSTRAINT_EXCLUSIVE,
+    ARGPARSER_CONSTRAINT_REQUIRES,
+    ARGPARSER_CONSTRAINT_RANGE,
+};
+
+typedef struct ArgparserConstraint
+{
+    enum ArgparserConstraintType type;
+    const char *options;            // Names separated by spaces
+    const char *required;           // Options required by ARGPARSER_CONSTRAINT_REQUIRES
+    double min;
+    double max;
+} ArgparserConstraint;
+
+typedef struct ArgparserError
+{
+    enum ArgparserErrorCode code;
+    int index;                      // Position of the offending argument in argv, -1 if unknown
+    const ArgparserOption *option;  // Offending option, NULL for unknown options
+    char *message;                  // Buffer for the error message, provided by the caller
+    size_t messageSize;
+} ArgparserError;
+
+#ifdef ARGPARSER_ENABLE_STATS
+typedef struct ArgparserOptionStats
+{
+    uint64_t hits;                  // Occurrences, bundled short options count individually
+    uint64_t callbackNs;
+} ArgparserOptionStats;
+
+typedef struct ArgparserStats
+{
+    uint64_t parses;
+    uint64_t arguments;
+    uint64_t parseNs;               // Total time spent in the parse functions
+    uint64_t lookupNs;              // Part of it spent finding options by name
+    uint64_t conversionNs;          // Part of it spent converting and storing values
+    uint64_t callbackNs;            // Part of it spent in callbacks
+    ArgparserOptionStats *options;  // One entry per option of the schema, including groups
+} ArgparserStats;
+#endif
+
+#ifdef ARGPARSER_ENABLE_THREADS
+typedef struct ArgparserBatchEntry
+{
+    int argc;
+    const char **argv;
+    void *output;               // Receives the values, see Argparser_setOutputTemplate()
+    int result;                 // Remaining amount of arguments, or -1 on errors
+    ArgparserError error;       // The message buffer may be set by the caller
+} ArgparserBatchEntry;
+#endif
+
+typedef struct ArgparserFile
+{
+    char *data;
+    size_t size;
+    bool mapped;                // Memory-mapped or read into an allocated buffer
+} ArgparserFile;
+
+typedef struct ArgparserIndexSlot
+{
+    uint32_t hash;
+    uint32_t option;    // Position in the option array plus one, 0 if empty
+} ArgparserIndexSlot;
+
+// FNV-1a, used for the long option index
+#define ARGPARSER_HASH_INIT         2166136261u
+#define ARGPARSER_HASH_STEP(h, c)   (((h) ^ (unsigned char)(c)) * 16777619u)
+
+// Perfect hash of the values of a choice option: every value has its own slot for the seed
+typedef struct ArgparserChoiceTable
+{
+    uint32_t seed;
+    uint32_t bits;      // The table has 2^bits slots
+    uint32_t first;     // Position of the first slot in choiceSlots
+} ArgparserChoiceTable;
+
+// Slot of a value with the FNV-1a hash `h`, from the high bits of a multiplicative hash
+#define ARGPARSER_CHOICE_SLOT(h, seed, bits)    ((((h) ^ (seed)) * 2654435761u) >> (32 - (bits)))
+
+// Columns of the help message reserved at most for the values of a choice option
+#define ARGPARSER_HINT_WIDTH                    24
+
+typedef struct ArgparserSchema
 {
-    bool valid;
     const ArgparserOption *options;
     const char *usage;
     const char *description;
     const char *epilog;
     bool stopAtNonOption;
+    bool responseFiles;
+    size_t optionCount;
+    const char *outputTemplate;
+    size_t outputSize;
+    ArgparserIndexSlot *longIndex;
+    uint32_t longIndexMask;
+    const ArgparserOption *shortIndex[256];
+    char *help;                     // Rendered help message, see Argparser_usage
+    size_t helpLength;
+    size_t helpCapacity;
+    size_t helpWidth;               // Terminal width used for the help message, 0 if not wrapped
+    bool shared;                    // Returned by Argparser_getSchema, read-only afterwards
+    const ArgparserCommand *commands;
+    size_t commandCount;
+    ArgparserIndexSlot *commandIndex;   // Command names, hashed like longIndex
+    uint32_t commandIndexMask;
+    struct ArgparserSchema **commandSchemas;    // Compiled on first use or by Argparser_getSchema, NULL before
+    bool abbreviations;
+    bool completion;
+    struct ArgparserTrieNode *prefixTrie;   // Long names for abbreviations and completion, NULL if unused
+    uint32_t *prefixOrder;                  // Option positions sorted by long name
+    struct ArgparserRule *rules;            // Constraints with resolved options
+    size_t ruleCount;
+    uint32_t *ruleOptions;                  // Option positions of all rules
+    ArgparserChoiceTable *choiceTables;     // Per option, NULL without choice options
+    uint32_t *choiceSlots;                  // Value positions plus one, 0 if empty
+    const char *envPrefix;
+    bool environment;                       // Set if environment variables are read, see Argparser_setEnvPrefix
+} ArgparserSchema;
+
+typedef struct Argparser
+{
+    bool valid;
+    const ArgparserSchema *schema;
+    ArgparserSchema *ownSchema;     // Created by Argparser_init, NULL for shared schemas
+    char *output;                   // Replaces the output template, see Argparser_setOutput
     // Internal variables
     int argc;
     const char **argv;
     const char **out;
     int cpidx;
+    ArgparserError *error;          // Set while running Argparser_tryParse
+    void *errorJump;
+    long indexBase;                 // Added to error positions, used by streams
+    struct ArgparserValueCopy *valueCopies; // Copies of string values from streams and config files, per option
+    bool copyValues;                // Set while the values do not outlive the parse
+    struct ArgparserArenaBlock *arena;  // Memory of list options, freed by Argparser_clear
+    ArgparserList **lists;          // Lists filled since the last reset, emptied by Argparser_reset
+    int listCount;
+    int listCapacity;
+    int *positions;                 // Positions of the remaining arguments, see Argparser_setPositionOutput
+    int positionCapacity;
+    // Subcommands
+    const ArgparserCommand *command;        // Selected by the last parse
+    const ArgparserSchema *parentSchema;    // Set while the options of a command are parsed
+    uint64_t *seen;                 // Options given in the current parse, followed by a snapshot
+    size_t *configLines;            // Lines of the options set by the config file, 0 for other options
+    // Config file
+    const char *configFile;
+    const char *sourceName;         // File of the values being parsed, prefixes error messages
+    size_t sourceLine;              // 0 if the values have no lines, e.g. environment variables
+    ArgparserIndexSlot *envIndex;   // Environment variables by name, rebuilt by each parse
+    uint32_t envIndexMask;
+    // Response files
+    ArgparserFile *files;
+    int fileCount;
+    int fileCapacity;
+    const char **expanded;
+    int expandedCount;
+    int expandedCapacity;
+    bool expansionStopped;
+#ifdef ARGPARSER_ENABLE_STATS
+    ArgparserStats stats;
+#endif
 } Argparser;
 
+#ifdef __cplusplus
+}
+#endif
+
 
 
 //******************************************************************************
@@ -184,337 +732,2977 @@ typedef struct Argparser
 #include <string.h>
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
+#include <locale.h>
+#include <math.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef ARGPARSER_ENABLE_THREADS
+#include <pthread.h>
+#endif
+#ifdef ARGPARSER_ENABLE_STATS
+#include <time.h>
+#endif
 
-Argparser* Argparser_new()
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Memory functions, may be defined before including the implementation, e.g. to count allocations.
+// All four have to be replaced together, so that memory is never freed by another allocator.
+#if defined(ARGPARSER_MALLOC) || defined(ARGPARSER_CALLOC) || defined(ARGPARSER_REALLOC) || defined(ARGPARSER_FREE)
+#if !defined(ARGPARSER_MALLOC) || !defined(ARGPARSER_CALLOC) || !defined(ARGPARSER_REALLOC) || !defined(ARGPARSER_FREE)
+#error "ARGPARSER_MALLOC, ARGPARSER_CALLOC, ARGPARSER_REALLOC, and ARGPARSER_FREE have to be defined together"
+#endif
+#else
+#define ARGPARSER_MALLOC(size)              malloc(size)
+#define ARGPARSER_CALLOC(count, size)       calloc(count, size)
+#define ARGPARSER_REALLOC(pointer, size)    realloc(pointer, size)
+#define ARGPARSER_FREE(pointer)             free(pointer)
+#endif
+
+#ifdef _WIN32
+#define ARGPARSER_ENVIRON _environ
+#else
+extern char **environ;
+#define ARGPARSER_ENVIRON environ
+#endif
+
+static void Argparser_fail(Argparser* self, enum ArgparserErrorCode code,
+    const ArgparserOption* option, const char* format, ...);
+
+// Exits if memory for the definition of options cannot be allocated, like other definition errors
+static void* Argparser_checkAllocation(void* memory)
 {
-    Argparser* self = malloc(sizeof(Argparser));
-    return self;
+    if (!memory) {
+        fprintf(stderr, "error: out of memory\n");
+        exit(1);
+    }
+    return memory;
 }
 
-void Argparser_init(Argparser* self, ArgparserOption* options)
+// Fails the current parse if memory cannot be allocated
+static void* Argparser_checkParseAllocation(Argparser* self, void* memory)
 {
-    memset(self, 0, sizeof(*self));
-    self->options = options;
-    self->valid = true;
+    if (!memory)
+        Argparser_fail(self, ARGPARSER_ERROR_MEMORY, NULL, "out of memory");
+    return memory;
 }
 
-void Argparser_clear(Argparser* self)
+#ifdef ARGPARSER_ENABLE_STATS
+static uint64_t Argparser_nowNs()
 {
-    self->valid = false;
+    struct timespec time;
+#if defined(CLOCK_MONOTONIC)
+    clock_gettime(CLOCK_MONOTONIC, &time);
+#else
+    timespec_get(&time, TIME_UTC);
+#endif
+    return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
 }
 
-void Argparser_delete(Argparser* self)
+// Allocates the per-option counters before the first parse
+static void Argparser_prepareStats(Argparser* self, int arguments)
 {
-    free(self);
+    if (!self->stats.options)
+        self->stats.options = (ArgparserOptionStats*)Argparser_checkParseAllocation(self,
+            ARGPARSER_CALLOC(self->schema->optionCount, sizeof(ArgparserOptionStats)));
+    self->stats.parses++;
+    self->stats.arguments += arguments;
 }
 
-void Argparser_setUsage(Argparser* self, const char* usage)
+#define ARGPARSER_STATS_PREPARE(self, arguments)    Argparser_prepareStats(self, arguments)
+#define ARGPARSER_STATS_START(start)                uint64_t start = Argparser_nowNs()
+#define ARGPARSER_STATS_STOP(self, field, start)    ((self)->stats.field += Argparser_nowNs() - (start))
+#else
+#define ARGPARSER_STATS_PREPARE(self, arguments)    ((void)0)
+#define ARGPARSER_STATS_START(start)                ((void)0)
+#define ARGPARSER_STATS_STOP(self, field, start)    ((void)0)
+#endif
+
+Argparser* Argparser_new()
 {
-    assert(self->valid);
-    self->usage = usage;
+    Argparser* self = (Argparser*)ARGPARSER_CALLOC(1, sizeof(Argparser));
+    return self;
 }
 
-void Argparser_setDescription(Argparser* self, const char* description)
+// Loads a file so that it can be modified in place, one writable byte follows its content.
+// The identity of the file is written to `id` to detect cycles.
+static bool Argparser_openFile(const char* path, ArgparserFile* file, uint64_t id[2])
 {
-    assert(self->valid);
-    self->description = description;
+    memset(file, 0, sizeof(*file));
+#ifdef _WIN32
+    FILE* stream = fopen(path, "rb");
+    struct _stat64 info;
+    if (!stream)
+        return false;
+    if (_fstat64(_fileno(stream), &info) || !(info.st_mode & _S_IFREG)) {
+        fclose(stream);
+        return false;
+    }
+    // Windows has no inode numbers, identify files by path instead
+    id[0] = 0;
+    id[1] = 2166136261u;
+    for (const char* c = path; *c; c++)
+        id[1] = (id[1] ^ (unsigned char)*c) * 16777619u;
+
+    file->size = (size_t)info.st_size;
+    file->data = (char*)ARGPARSER_MALLOC(file->size + 1);
+    if (!file->data) {
+        fclose(stream);
+        return false;
+    }
+    file->size = fread(file->data, 1, file->size, stream);
+    fclose(stream);
+#else
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0)
+        return false;
+    if (fstat(fd, &info) || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return false;
+    }
+    id[0] = (uint64_t)info.st_dev;
+    id[1] = (uint64_t)info.st_ino;
+    file->size = (size_t)info.st_size;
+
+    // Private mappings are copy-on-write. The rest of the last page is zeroed and writable,
+    // so only page-aligned files lack the spare byte and are read instead.
+    if (file->size % (size_t)sysconf(_SC_PAGESIZE)) {
+        void* data = mmap(NULL, file->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            file->data = (char*)data;
+            file->mapped = true;
+            close(fd);
+            return true;
+        }
+    }
+
+    file->data = (char*)ARGPARSER_MALLOC(file->size + 1);
+    if (!file->data) {
+        close(fd);
+        return false;
+    }
+    size_t length = 0;
+    while (length < file->size) {
+        ssize_t count = read(fd, file->data + length, file->size - length);
+        if (count <= 0)
+            break;
+        length += (size_t)count;
+    }
+    file->size = length;
+    close(fd);
+#endif
+    return true;
 }
 
-void Argparser_setEpilog(Argparser* self, const char* epilog)
+static void Argparser_releaseFile(const ArgparserFile* file)
 {
-    assert(self->valid);
-    self->epilog = epilog;
+#ifndef _WIN32
+    if (file->mapped) {
+        munmap(file->data, file->size);
+        return;
+    }
+#endif
+    ARGPARSER_FREE(file->data);
 }
 
-void Argparser_setStopAtNonOption(Argparser* self, bool stop)
+static void Argparser_releaseFiles(Argparser* self)
 {
-    assert(self->valid);
-    self->stopAtNonOption = stop;
+    for (int i = 0; i < self->fileCount; i++)
+        Argparser_releaseFile(&self->files[i]);
+    self->fileCount = 0;
 }
 
-void Argparser_usage(Argparser* self)
+// Grows to the longest value of its option and is reused afterwards
+typedef struct ArgparserValueCopy
 {
-    // print usage
-    if (self->usage)
-        fprintf(stdout, "Usage: %s\n", self->usage);
+    char *text;
+    size_t capacity;
+} ArgparserValueCopy;
 
-    // print description
-    if (self->description)
-        fprintf(stdout, "%s\n", self->description);
+typedef struct ArgparserArenaBlock
+{
+    struct ArgparserArenaBlock *next;   // Previous, full block
+    size_t size;
+    size_t used;
+    max_align_t data[];
+} ArgparserArenaBlock;
 
-    const struct ArgparserOption *options;
+static void* Argparser_allocate(Argparser* self, size_t size)
+{
+    size = (size + sizeof(max_align_t) - 1) / sizeof(max_align_t) * sizeof(max_align_t);
+    ArgparserArenaBlock* block = self->arena;
+    if (!block || block->size - block->used < size) {
+        // Blocks grow geometrically, so a growing list needs only a few allocations
+        size_t blockSize = block ? 2 * block->size : 4096;
+        while (blockSize < size)
+            blockSize *= 2;
+        block = (ArgparserArenaBlock*)Argparser_checkParseAllocation(self,
+            ARGPARSER_MALLOC(sizeof(ArgparserArenaBlock) + blockSize));
+        block->next = self->arena;
+        block->size = blockSize;
+        block->used = 0;
+        self->arena = block;
+    }
+    void* memory = (char*)block->data + block->used;
+    block->used += size;
+    return memory;
+}
 
-    // figure out best width
-    size_t usage_opts_width = 0;
-    size_t len;
-    options = self->options;
-    for (; options->type != ARGPARSER_TYPE_END; options++) {
-        len = 0;
-        if (options->shortName) {
-            len += 2;
-        }
-        if (options->shortName && options->longName) {
-            len += 2;           // separator ", "
-        }
-        if (options->longName) {
-            len += strlen(options->longName) + 2;
-        }
+// Remembers a list once, its items are released by Argparser_reset
+static void Argparser_rememberList(Argparser* self, ArgparserList* list)
+{
+    for (int i = 0; i < self->listCount; i++) {
+        if (self->lists[i] == list)
+            return;
+    }
+    if (self->listCount == self->listCapacity) {
+        int capacity = self->listCapacity ? 2 * self->listCapacity : 8;
+        self->lists = (ArgparserList**)Argparser_checkParseAllocation(self,
+            ARGPARSER_REALLOC(self->lists, capacity * sizeof(ArgparserList*)));
+        self->listCapacity = capacity;
+    }
+    self->lists[self->listCount++] = list;
+}
 
-        if (options->type == ARGPARSER_TYPE_INTEGER) {
-            len += strlen("=<int>");
-        } else if (options->type == ARGPARSER_TYPE_FLOAT) {
-            len += strlen("=<float>");
-        } else if (options->type == ARGPARSER_TYPE_STRING) {
-            len += strlen("=<string>");
-        }
-        len = (len + 3) - ((len + 3) & 3);
-        if (usage_opts_width < len) {
-            usage_opts_width = len;
+// Returns the address of a new item at the end of the list
+static void* Argparser_appendToList(Argparser* self, ArgparserList* list, size_t itemSize)
+{
+    if (!list->count)
+        Argparser_rememberList(self, list);
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? 2 * list->capacity : 8;
+        ArgparserArenaBlock* block = self->arena;
+        char* top = block ? (char*)block->data + block->used : NULL;
+        size_t growth = (size_t)(capacity - list->capacity) * itemSize;
+
+        if (list->items && (char*)list->items + list->capacity * itemSize == top
+            && block->size - block->used >= growth) {
+            // The items are the latest allocation, grow them in place
+            block->used += growth;
+        } else {
+            void* items = Argparser_allocate(self, capacity * itemSize);
+            if (list->count)
+                memcpy(items, list->items, list->count * itemSize);
+            list->items = items;
         }
+        list->capacity = capacity;
     }
-    usage_opts_width += 4;      // 4 spaces prefix
+    return (char*)list->items + list->count++ * itemSize;
+}
 
-    options = self->options;
-    for (; options->type != ARGPARSER_TYPE_END; options++) {
-        size_t pos = 0;
-        int pad    = 0;
-        if (options->type == ARGPARSER_TYPE_GROUP) {
-            fputc('\n', stdout);
-            fprintf(stdout, "%s", options->help);
-            fputc('\n', stdout);
+static void Argparser_buildLongIndex(ArgparserSchema* self)
+{
+    size_t count = 0;
+    for (const ArgparserOption* option = self->options; option->type != ARGPARSER_TYPE_END; option++) {
+        if (option->longName && option->longName[0])
+            count++;
+    }
+
+    // Keep the load factor at or below 50% so probe sequences stay short
+    uint32_t size = 8;
+    while (size < 2 * count)
+        size <<= 1;
+    self->longIndex = (ArgparserIndexSlot*)Argparser_checkAllocation(
+        ARGPARSER_CALLOC(size, sizeof(ArgparserIndexSlot)));
+    self->longIndexMask = size - 1;
+
+    for (const ArgparserOption* option = self->options; option->type != ARGPARSER_TYPE_END; option++) {
+        if (!option->longName || !option->longName[0])
             continue;
+
+        uint32_t hash = ARGPARSER_HASH_INIT;
+        for (const char* c = option->longName; *c; c++)
+            hash = ARGPARSER_HASH_STEP(hash, *c);
+
+        uint32_t i = hash & self->longIndexMask;
+        for (; self->longIndex[i].option; i = (i + 1) & self->longIndexMask) {
+            const ArgparserOption* other = self->options + self->longIndex[i].option - 1;
+            if (self->longIndex[i].hash == hash && strcmp(other->longName, option->longName) == 0) {
+                fprintf(stderr, "error: option `--%s` is defined more than once\n", option->longName);
+                exit(1);
+            }
         }
-        pos = fprintf(stdout, "    ");
-        if (options->shortName) {
-            pos += fprintf(stdout, "-%c", options->shortName);
-        }
-        if (options->longName && options->shortName) {
-            pos += fprintf(stdout, ", ");
-        }
-        if (options->longName) {
-            pos += fprintf(stdout, "--%s", options->longName);
-        }
+        self->longIndex[i].hash = hash;
+        self->longIndex[i].option = (uint32_t)(option - self->options) + 1;
+    }
+}
+
+// Finds a seed for each choice option that maps its values to distinct slots
+static void Argparser_buildChoices(ArgparserSchema* self)
+{
+    size_t used = 0, capacity = 0;
+    for (size_t o = 0; o < self->optionCount; o++) {
+        const ArgparserOption* option = &self->options[o];
+        if (option->type != ARGPARSER_TYPE_CHOICE)
+            continue;
+        if (!self->choiceTables)
+            self->choiceTables = (ArgparserChoiceTable*)Argparser_checkAllocation(
+                ARGPARSER_CALLOC(self->optionCount, sizeof(ArgparserChoiceTable)));
 
-        if (options->type == ARGPARSER_TYPE_INTEGER) {
-            pos += fprintf(stdout, "=<int>");
-        } else if (options->type == ARGPARSER_TYPE_FLOAT) {
-            pos += fprintf(stdout, "=<float>");
-        } else if (options->type == ARGPARSER_TYPE_STRING) {
-            pos += fprintf(stdout, "=<string>");
+        uint32_t count = 0;
+        while (option->choices && option->choices[count])
+            count++;
+        if (!count) {
+            fprintf(stderr, "error: option `--%s` has no choices\n", option->longName);
+            exit(1);
         }
 
-        if (pos <= usage_opts_width) {
-            pad = usage_opts_width - pos;
-        } else {
-            fputc('\n', stdout);
-            pad = usage_opts_width;
+        // Try a few seeds per size, larger tables make collisions rarer
+        ArgparserChoiceTable* table = &self->choiceTables[o];
+        table->bits = 1;
+        while ((1u << table->bits) < 2 * count)
+            table->bits++;
+        for (;; table->bits++) {
+            if (table->bits > 20) {
+                fprintf(stderr, "error: choices of option `--%s` cannot be hashed, are they unique?\n", option->longName);
+                exit(1);
+            }
+            size_t size = (size_t)1 << table->bits;
+            if (used + size > capacity) {
+                capacity = used + size > 2 * capacity ? used + size : 2 * capacity;
+                self->choiceSlots = (uint32_t*)Argparser_checkAllocation(
+                    ARGPARSER_REALLOC(self->choiceSlots, capacity * sizeof(uint32_t)));
+            }
+            uint32_t* slots = self->choiceSlots + used;
+            for (table->seed = 0; table->seed < 64; table->seed++) {
+                memset(slots, 0, size * sizeof(uint32_t));
+                uint32_t c = 0;
+                for (; c < count; c++) {
+                    uint32_t hash = ARGPARSER_HASH_INIT;
+                    for (const char* v = option->choices[c]; *v; v++)
+                        hash = ARGPARSER_HASH_STEP(hash, *v);
+                    uint32_t* slot = &slots[ARGPARSER_CHOICE_SLOT(hash, table->seed, table->bits)];
+                    if (*slot)
+                        break;
+                    *slot = c + 1;
+                }
+                if (c == count)
+                    break;
+            }
+            if (table->seed < 64)
+                break;
         }
-        fprintf(stdout, "%*s%s\n", pad + 2, "", options->help);
+        table->first = (uint32_t)used;
+        used += (size_t)1 << table->bits;
     }
-
-    // print epilog
-    if (self->epilog)
-        fprintf(stdout, "\n%s\n", self->epilog);
 }
 
-void Argparser_exitForHelp(Argparser* self, const ArgparserOption* option)
+// Returns the position of the value in the choices of the option, or -1
+static int Argparser_findChoice(const ArgparserSchema* self, const ArgparserOption* option, const char* value)
 {
-    Argparser_usage(self);
-    exit(0);
+    const ArgparserChoiceTable* table = &self->choiceTables[option - self->options];
+    uint32_t hash = ARGPARSER_HASH_INIT;
+    for (const char* c = value; *c; c++)
+        hash = ARGPARSER_HASH_STEP(hash, *c);
+    uint32_t slot = self->choiceSlots[table->first + ARGPARSER_CHOICE_SLOT(hash, table->seed, table->bits)];
+    return slot && strcmp(option->choices[slot - 1], value) == 0 ? (int)slot - 1 : -1;
 }
 
-void Argparser_exitDueToUnknownOption(Argparser* self)
+static void Argparser_buildShortIndex(ArgparserSchema* self)
 {
-    fprintf(stderr, "error: unknown option `%s`\n", self->argv[0]);
-    Argparser_usage(self);
-    exit(1);
+    for (const ArgparserOption* option = self->options; option->type != ARGPARSER_TYPE_END; option++) {
+        self->optionCount++;
+        if (option->env)
+            self->environment = true;
+        if (!option->shortName)
+            continue;
+
+        const ArgparserOption** slot = &self->shortIndex[(unsigned char)option->shortName];
+        if (*slot) {
+            fprintf(stderr, "error: option `-%c` is defined more than once\n", option->shortName);
+            exit(1);
+        }
+        *slot = option;
+    }
 }
 
-void Argparser_exitDueToError(Argparser* self, const ArgparserOption* option, const char* reason)
+static const ArgparserOption* Argparser_findLongOption(const ArgparserSchema* self,
+    const char* name, size_t length, uint32_t hash)
 {
-    fprintf(stderr, "error: option `-%c`/`--%s` %s\n", option->shortName, option->longName, reason);
-    exit(1);
+    uint32_t i = hash & self->longIndexMask;
+    for (; self->longIndex[i].option; i = (i + 1) & self->longIndexMask) {
+        const ArgparserOption* option = self->options + self->longIndex[i].option - 1;
+        if (self->longIndex[i].hash == hash
+            && strncmp(option->longName, name, length) == 0
+            && option->longName[length] == '\0')
+            return option;
+    }
+    return NULL;
 }
 
-void Argparser_parseValue(Argparser* self, const ArgparserOption* option, const char *optvalue)
+typedef struct ArgparserTrieNode
 {
-    const char *s = NULL;
-    if (option->value) {
+    const char *label;          // Points into the long name of the first option below
+    uint32_t labelLength;
+    uint32_t children;          // Position of the first child, children are stored consecutively
+    uint32_t childCount;
+    uint32_t first;             // Options below this node, as range of `prefixOrder`
+    uint32_t count;
+} ArgparserTrieNode;
+
+static int Argparser_compareLongNames(const void* a, const void* b)
+{
+    return strcmp((*(const ArgparserOption* const*)a)->longName, (*(const ArgparserOption* const*)b)->longName);
+}
+
+// Fills `node` with the sorted names [first, first + count), which share their first `depth` characters
+static void Argparser_buildTrieNode(ArgparserSchema* self, const ArgparserOption** sorted,
+    uint32_t node, uint32_t first, uint32_t count, size_t depth, uint32_t* used)
+{
+    // The common prefix of sorted names is the one of the first and the last name
+    const char* low = sorted[first]->longName;
+    const char* high = sorted[first + count - 1]->longName;
+    size_t end = depth;
+    while (low[end] && low[end] == high[end])
+        end++;
+
+    ArgparserTrieNode* trie = self->prefixTrie;
+    trie[node].label = low + depth;
+    trie[node].labelLength = (uint32_t)(end - depth);
+    trie[node].first = first;
+    trie[node].count = count;
+
+    // A name ending here sorts first, the others are grouped by their next character
+    uint32_t start = first + (low[end] == '\0');
+    uint32_t childCount = 0;
+    for (uint32_t i = start; i < first + count; i++) {
+        if (i == start || sorted[i]->longName[end] != sorted[i - 1]->longName[end])
+            childCount++;
+    }
+    trie[node].children = *used;
+    trie[node].childCount = childCount;
+    *used += childCount;
+
+    uint32_t child = trie[node].children;
+    for (uint32_t i = start; i < first + count; ) {
+        uint32_t j = i + 1;
+        while (j < first + count && sorted[j]->longName[end] == sorted[i]->longName[end])
+            j++;
+        Argparser_buildTrieNode(self, sorted, child++, i, j - i, end, used);
+        i = j;
+    }
+}
+
+static void Argparser_buildTrie(ArgparserSchema* self)
+{
+    uint32_t count = 0;
+    for (const ArgparserOption* option = self->options; option->type != ARGPARSER_TYPE_END; option++) {
+        if (option->longName && option->longName[0])
+            count++;
+    }
+    if (!count)
+        return;
+
+    const ArgparserOption** sorted = (const ArgparserOption**)Argparser_checkAllocation(
+        ARGPARSER_MALLOC(count * sizeof(*sorted)));
+    count = 0;
+    for (const ArgparserOption* option = self->options; option->type != ARGPARSER_TYPE_END; option++) {
+        if (option->longName && option->longName[0])
+            sorted[count++] = option;
+    }
+    qsort(sorted, count, sizeof(*sorted), Argparser_compareLongNames);
+
+    // Every node but the root splits the names, so there are less than two nodes per name
+    self->prefixTrie = (ArgparserTrieNode*)Argparser_checkAllocation(
+        ARGPARSER_MALLOC(2 * count * sizeof(ArgparserTrieNode)));
+    self->prefixOrder = (uint32_t*)Argparser_checkAllocation(ARGPARSER_MALLOC(count * sizeof(uint32_t)));
+    for (uint32_t i = 0; i < count; i++)
+        self->prefixOrder[i] = (uint32_t)(sorted[i] - self->options);
+    uint32_t used = 1;
+    Argparser_buildTrieNode(self, sorted, 0, 0, count, 0, &used);
+    ARGPARSER_FREE(sorted);
+}
+
+static void Argparser_releaseTrie(ArgparserSchema* self)
+{
+    ARGPARSER_FREE(self->prefixTrie);
+    ARGPARSER_FREE(self->prefixOrder);
+    self->prefixTrie = NULL;
+    self->prefixOrder = NULL;
+}
+
+// Returns the node of all names starting with the given prefix, or NULL if there is none
+static const ArgparserTrieNode* Argparser_findPrefix(const ArgparserSchema* self, const char* name, size_t length)
+{
+    const ArgparserTrieNode* node = self->prefixTrie;
+    size_t position = 0;
+    for (;;) {
+        size_t n = node->labelLength < length - position ? node->labelLength : length - position;
+        if (memcmp(node->label, name + position, n) != 0)
+            return NULL;
+        position += n;
+        if (position == length)
+            return node;
+
+        const ArgparserTrieNode* child = self->prefixTrie + node->children;
+        const ArgparserTrieNode* end = child + node->childCount;
+        while (child < end && child->label[0] != name[position])
+            child++;
+        if (child == end)
+            return NULL;
+        node = child;
+    }
+}
+
+// Builds the indices of an option table, exits if a name is used twice
+static ArgparserSchema* Argparser_compileSchema(ArgparserOption* options)
+{
+    ArgparserSchema* schema = (ArgparserSchema*)Argparser_checkAllocation(ARGPARSER_CALLOC(1, sizeof(ArgparserSchema)));
+    schema->options = options;
+    Argparser_buildShortIndex(schema);
+    Argparser_buildLongIndex(schema);
+    Argparser_buildChoices(schema);
+    return schema;
+}
+
+static void Argparser_freeSchema(ArgparserSchema* schema);
+
+static void Argparser_releaseCommands(ArgparserSchema* schema)
+{
+    for (size_t i = 0; i < schema->commandCount; i++) {
+        if (schema->commandSchemas[i])
+            Argparser_freeSchema(schema->commandSchemas[i]);
+    }
+    ARGPARSER_FREE(schema->commandSchemas);
+    ARGPARSER_FREE(schema->commandIndex);
+    schema->commands = NULL;
+    schema->commandCount = 0;
+    schema->commandSchemas = NULL;
+    schema->commandIndex = NULL;
+}
+
+static void Argparser_freeSchema(ArgparserSchema* schema)
+{
+    Argparser_releaseCommands(schema);
+    Argparser_releaseTrie(schema);
+    ARGPARSER_FREE(schema->rules);
+    ARGPARSER_FREE(schema->ruleOptions);
+    ARGPARSER_FREE(schema->choiceTables);
+    ARGPARSER_FREE(schema->choiceSlots);
+    ARGPARSER_FREE(schema->longIndex);
+    ARGPARSER_FREE(schema->help);
+    ARGPARSER_FREE(schema);
+}
+
+static const ArgparserCommand* Argparser_findCommand(const ArgparserSchema* self, const char* name)
+{
+    uint32_t hash = ARGPARSER_HASH_INIT;
+    for (const char* c = name; *c; c++)
+        hash = ARGPARSER_HASH_STEP(hash, *c);
+
+    uint32_t i = hash & self->commandIndexMask;
+    for (; self->commandIndex[i].option; i = (i + 1) & self->commandIndexMask) {
+        const ArgparserCommand* command = self->commands + self->commandIndex[i].option - 1;
+        if (self->commandIndex[i].hash == hash && strcmp(command->name, name) == 0)
+            return command;
+    }
+    return NULL;
+}
+
+void Argparser_init(Argparser* self, ArgparserOption* options)
+{
+    memset(self, 0, sizeof(*self));
+    self->ownSchema = Argparser_compileSchema(options);
+    self->schema = self->ownSchema;
+    self->valid = true;
+}
+
+void Argparser_initWithSchema(Argparser* self, const ArgparserSchema* schema)
+{
+    memset(self, 0, sizeof(*self));
+    self->schema = schema;
+    self->valid = true;
+}
+
+// Indexes the options of a command and inherits the settings of its parent
+static void Argparser_compileCommand(ArgparserSchema* parent, size_t c)
+{
+    ArgparserSchema* schema = Argparser_compileSchema(parent->commands[c].options);
+    schema->description = parent->commands[c].help;
+    schema->abbreviations = parent->abbreviations;
+    if (parent->abbreviations || parent->completion)
+        Argparser_buildTrie(schema);
+    parent->commandSchemas[c] = schema;
+}
+
+static size_t Argparser_terminalWidth();
+static void Argparser_updateHelp(Argparser* self, size_t width);
+static void Argparser_invalidateHelp(ArgparserSchema* schema);
+
+const ArgparserSchema* Argparser_getSchema(const Argparser* self)
+{
+    assert(self->valid);
+    // Shared schemas are read-only, so their help and commands are prepared now
+    ArgparserSchema* schema = self->ownSchema;
+    if (schema && !schema->help)
+        Argparser_updateHelp((Argparser*)self, Argparser_terminalWidth());
+    for (size_t c = 0; schema && c < schema->commandCount; c++) {
+        if (!schema->commandSchemas[c])
+            Argparser_compileCommand(schema, c);
+    }
+    if (schema)
+        schema->shared = true;
+    return self->schema;
+}
+
+void Argparser_clear(Argparser* self)
+{
+    if (self->parentSchema) {
+        self->schema = self->parentSchema;
+        self->parentSchema = NULL;
+    }
+    self->command = NULL;
+
+    Argparser_releaseFiles(self);
+    ARGPARSER_FREE(self->files);
+    ARGPARSER_FREE(self->expanded);
+    self->files = NULL;
+    self->expanded = NULL;
+    self->fileCapacity = 0;
+    self->expandedCapacity = 0;
+
+    while (self->arena) {
+        struct ArgparserArenaBlock* next = self->arena->next;
+        ARGPARSER_FREE(self->arena);
+        self->arena = next;
+    }
+    ARGPARSER_FREE(self->lists);
+    self->lists = NULL;
+    self->listCount = 0;
+    self->listCapacity = 0;
+
+#ifdef ARGPARSER_ENABLE_STATS
+    ARGPARSER_FREE(self->stats.options);
+    memset(&self->stats, 0, sizeof(self->stats));
+#endif
+
+    if (self->valueCopies) {
+        for (size_t i = 0; i < self->schema->optionCount; i++)
+            ARGPARSER_FREE(self->valueCopies[i].text);
+        ARGPARSER_FREE(self->valueCopies);
+        self->valueCopies = NULL;
+    }
+
+    ARGPARSER_FREE(self->seen);
+    self->seen = NULL;
+    ARGPARSER_FREE(self->configLines);
+    self->configLines = NULL;
+    ARGPARSER_FREE(self->envIndex);
+    self->envIndex = NULL;
+
+    if (self->ownSchema) {
+        Argparser_freeSchema(self->ownSchema);
+        self->ownSchema = NULL;
+    }
+    self->schema = NULL;
+    self->valid = false;
+}
+
+void Argparser_delete(Argparser* self)
+{
+    if (self && self->valid)
+        Argparser_clear(self);
+    ARGPARSER_FREE(self);
+}
+
+void Argparser_setUsage(Argparser* self, const char* usage)
+{
+    assert(self->valid && self->ownSchema);
+    self->ownSchema->usage = usage;
+    Argparser_invalidateHelp(self->ownSchema);
+}
+
+void Argparser_setDescription(Argparser* self, const char* description)
+{
+    assert(self->valid && self->ownSchema);
+    self->ownSchema->description = description;
+    Argparser_invalidateHelp(self->ownSchema);
+}
+
+void Argparser_setEpilog(Argparser* self, const char* epilog)
+{
+    assert(self->valid && self->ownSchema);
+    self->ownSchema->epilog = epilog;
+    Argparser_invalidateHelp(self->ownSchema);
+}
+
+void Argparser_setStopAtNonOption(Argparser* self, bool stop)
+{
+    assert(self->valid && self->ownSchema);
+    self->ownSchema->stopAtNonOption = stop;
+}
+
+void Argparser_setResponseFiles(Argparser* self, bool enable)
+{
+    assert(self->valid && self->ownSchema);
+    self->ownSchema->responseFiles = enable;
+}
+
+// Builds the trie if abbreviations or completion need it, also for compiled commands
+static void Argparser_updateTries(ArgparserSchema* schema)
+{
+    bool needed = schema->abbreviations || schema->completion;
+    for (size_t i = 0; i <= schema->commandCount; i++) {
+        ArgparserSchema* target = i < schema->commandCount ? schema->commandSchemas[i] : schema;
+        if (!target)
+            continue;
+        target->abbreviations = schema->abbreviations;
+        if (needed && !target->prefixTrie)
+            Argparser_buildTrie(target);
+        else if (!needed)
+            Argparser_releaseTrie(target);
+    }
+}
+
+void Argparser_setCommands(Argparser* self, const ArgparserCommand* commands)
+{
+    assert(self->valid && self->ownSchema);
+    ArgparserSchema* schema = self->ownSchema;
+    Argparser_releaseCommands(schema);
+
+    size_t count = 0;
+    while (commands[count].name)
+        count++;
+
+    uint32_t size = 8;
+    while (size < 2 * count)
+        size <<= 1;
+    schema->commandIndex = (ArgparserIndexSlot*)Argparser_checkAllocation(
+        ARGPARSER_CALLOC(size, sizeof(ArgparserIndexSlot)));
+    schema->commandIndexMask = size - 1;
+    schema->commandSchemas = (ArgparserSchema**)Argparser_checkAllocation(
+        ARGPARSER_CALLOC(count ? count : 1, sizeof(ArgparserSchema*)));
+    schema->commands = commands;
+    schema->commandCount = count;
+
+    for (size_t c = 0; c < count; c++) {
+        if (Argparser_findCommand(schema, commands[c].name)) {
+            fprintf(stderr, "error: command `%s` is defined more than once\n", commands[c].name);
+            exit(1);
+        }
+        uint32_t hash = ARGPARSER_HASH_INIT;
+        for (const char* n = commands[c].name; *n; n++)
+            hash = ARGPARSER_HASH_STEP(hash, *n);
+
+        uint32_t i = hash & schema->commandIndexMask;
+        while (schema->commandIndex[i].option)
+            i = (i + 1) & schema->commandIndexMask;
+        schema->commandIndex[i].hash = hash;
+        schema->commandIndex[i].option = (uint32_t)c + 1;
+    }
+    Argparser_invalidateHelp(schema);
+}
+
+void Argparser_setAllowAbbreviations(Argparser* self, bool allow)
+{
+    assert(self->valid && self->ownSchema);
+    self->ownSchema->abbreviations = allow;
+    Argparser_updateTries(self->ownSchema);
+}
+
+void Argparser_setCompletion(Argparser* self, bool enable)
+{
+    assert(self->valid && self->ownSchema);
+    self->ownSchema->completion = enable;
+    Argparser_updateTries(self->ownSchema);
+}
+
+typedef struct ArgparserRule
+{
+    enum ArgparserConstraintType type;
+    uint32_t first;             // Options in `ruleOptions`
+    uint32_t count;
+    uint32_t requiredFirst;     // Required options of ARGPARSER_CONSTRAINT_REQUIRES
+    uint32_t requiredCount;
+    double min;
+    double max;
+} ArgparserRule;
+
+// Appends the positions of the named options to `ruleOptions`, returns their amount
+static uint32_t Argparser_resolveNames(ArgparserSchema* schema, const char* names, uint32_t* used, size_t* capacity)
+{
+    uint32_t count = 0;
+    while (names && *names) {
+        size_t length = strcspn(names, " ");
+        const ArgparserOption* option = NULL;
+        if (length == 2 && names[0] == '-' && names[1] != '-') {
+            option = schema->shortIndex[(unsigned char)names[1]];
+        } else if (length > 2 && names[0] == '-' && names[1] == '-') {
+            uint32_t hash = ARGPARSER_HASH_INIT;
+            for (size_t i = 2; i < length; i++)
+                hash = ARGPARSER_HASH_STEP(hash, names[i]);
+            option = Argparser_findLongOption(schema, names + 2, length - 2, hash);
+        }
+        if (length && !option) {
+            fprintf(stderr, "error: constraint refers to unknown option `%.*s`\n", (int)length, names);
+            exit(1);
+        }
+
+        if (option) {
+            if (*used == *capacity) {
+                *capacity = *capacity ? 2 * *capacity : 16;
+                schema->ruleOptions = (uint32_t*)Argparser_checkAllocation(
+                    ARGPARSER_REALLOC(schema->ruleOptions, *capacity * sizeof(uint32_t)));
+            }
+            schema->ruleOptions[(*used)++] = (uint32_t)(option - schema->options);
+            count++;
+        }
+        names += length;
+        while (*names == ' ')
+            names++;
+    }
+    return count;
+}
+
+static bool Argparser_isNumeric(const ArgparserOption* option)
+{
+    switch (option->type) {
+    case ARGPARSER_TYPE_INTEGER:
+    case ARGPARSER_TYPE_FLOAT:
+    case ARGPARSER_TYPE_INT64:
+    case ARGPARSER_TYPE_UINT64:
+    case ARGPARSER_TYPE_DOUBLE:
+    case ARGPARSER_TYPE_SIZE:
+    case ARGPARSER_TYPE_INTEGER_LIST:
+    case ARGPARSER_TYPE_FLOAT_LIST:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void Argparser_setConstraints(Argparser* self, const ArgparserConstraint* constraints)
+{
+    assert(self->valid && self->ownSchema);
+    ArgparserSchema* schema = self->ownSchema;
+    ARGPARSER_FREE(schema->rules);
+    ARGPARSER_FREE(schema->ruleOptions);
+    schema->rules = NULL;
+    schema->ruleOptions = NULL;
+    schema->ruleCount = 0;
+
+    size_t count = 0;
+    while (constraints[count].type != ARGPARSER_CONSTRAINT_END)
+        count++;
+    schema->rules = (ArgparserRule*)Argparser_checkAllocation(
+        ARGPARSER_CALLOC(count ? count : 1, sizeof(ArgparserRule)));
+
+    size_t capacity = 0;
+    uint32_t used = 0;
+    for (size_t c = 0; c < count; c++) {
+        ArgparserRule* rule = &schema->rules[c];
+        rule->type = constraints[c].type;
+        rule->min = constraints[c].min;
+        rule->max = constraints[c].max;
+        rule->first = used;
+        rule->count = Argparser_resolveNames(schema, constraints[c].options, &used, &capacity);
+        rule->requiredFirst = used;
+        rule->requiredCount = Argparser_resolveNames(schema, constraints[c].required, &used, &capacity);
+        schema->ruleCount++;
+
+        for (uint32_t i = 0; rule->type == ARGPARSER_CONSTRAINT_RANGE && i < rule->count; i++) {
+            const ArgparserOption* option = &schema->options[schema->ruleOptions[rule->first + i]];
+            if (!Argparser_isNumeric(option)) {
+                fprintf(stderr, "error: range of option `%s` requires a numeric type\n", constraints[c].options);
+                exit(1);
+            }
+        }
+    }
+}
+
+void Argparser_setConfigFile(Argparser* self, const char* path)
+{
+    assert(self->valid);
+    self->configFile = path;
+}
+
+void Argparser_setEnvPrefix(Argparser* self, const char* prefix)
+{
+    assert(self->valid && self->ownSchema);
+    self->ownSchema->envPrefix = prefix;
+    if (prefix)
+        self->ownSchema->environment = true;
+}
+
+void Argparser_setOutputTemplate(Argparser* self, const void* outputTemplate, size_t size)
+{
+    assert(self->valid && self->ownSchema);
+    self->ownSchema->outputTemplate = (const char*)outputTemplate;
+    self->ownSchema->outputSize = size;
+}
+
+void Argparser_setOutput(Argparser* self, void* output)
+{
+    assert(self->valid);
+    self->output = (char*)output;
+}
+
+void* Argparser_getValue(const Argparser* self, const ArgparserOption* option)
+{
+    const char* value = (const char*)option->value;
+    const char* outputTemplate = self->schema->outputTemplate;
+    if (self->output && value >= outputTemplate && value < outputTemplate + self->schema->outputSize)
+        return self->output + (value - outputTemplate);
+    return option->value;
+}
+
+// Placeholder for the value in the help message
+static const char* Argparser_valueHint(const ArgparserOption* option)
+{
+    switch (option->type) {
+    case ARGPARSER_TYPE_INTEGER:    return "=<int>";
+    case ARGPARSER_TYPE_FLOAT:      return "=<float>";
+    case ARGPARSER_TYPE_STRING:     return "=<string>";
+    case ARGPARSER_TYPE_INT64:      return "=<int64>";
+    case ARGPARSER_TYPE_UINT64:     return "=<uint64>";
+    case ARGPARSER_TYPE_DOUBLE:     return "=<double>";
+    case ARGPARSER_TYPE_SIZE:       return "=<size>";
+    case ARGPARSER_TYPE_STRING_LIST:    return "=<string>...";
+    case ARGPARSER_TYPE_INTEGER_LIST:   return "=<int>...";
+    case ARGPARSER_TYPE_FLOAT_LIST:     return "=<float>...";
+    default:                        return "";
+    }
+}
+
+typedef struct ArgparserBuffer
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+} ArgparserBuffer;
+
+static void Argparser_append(ArgparserBuffer* buffer, const char* text, size_t length)
+{
+    if (buffer->length + length > buffer->capacity) {
+        buffer->capacity = buffer->capacity ? 2 * buffer->capacity : 1024;
+        if (buffer->capacity < buffer->length + length)
+            buffer->capacity = buffer->length + length;
+        buffer->data = (char*)Argparser_checkAllocation(ARGPARSER_REALLOC(buffer->data, buffer->capacity));
+    }
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+}
+
+static void Argparser_appendString(ArgparserBuffer* buffer, const char* text)
+{
+    Argparser_append(buffer, text, strlen(text));
+}
+
+static void Argparser_appendSpaces(ArgparserBuffer* buffer, size_t count)
+{
+    static const char spaces[] = "                                ";
+    for (; count > sizeof(spaces) - 1; count -= sizeof(spaces) - 1)
+        Argparser_append(buffer, spaces, sizeof(spaces) - 1);
+    Argparser_append(buffer, spaces, count);
+}
+
+// Columns of the terminal on stdout, COLUMNS, or 80
+static size_t Argparser_terminalWidth()
+{
+#if !defined(_WIN32) && defined(TIOCGWINSZ)
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0)
+        return size.ws_col;
+#endif
+    const char* columns = getenv("COLUMNS");
+    long width = columns ? strtol(columns, NULL, 10) : 0;
+    return width > 0 ? (size_t)width : 80;
+}
+
+// Appends the text word by word, starting lines at `indent` and breaking them before `width`
+static void Argparser_appendWrapped(ArgparserBuffer* buffer, const char* text, size_t indent, size_t width)
+{
+    // Too narrow terminals would only get a word per line
+    if (width < indent + 20) {
+        Argparser_appendString(buffer, text);
+        return;
+    }
+
+    size_t column = indent;
+    while (*text) {
+        if (*text == '\n') {
+            Argparser_append(buffer, "\n", 1);
+            Argparser_appendSpaces(buffer, indent);
+            column = indent;
+            text++;
+            continue;
+        }
+        const char* word = text;
+        size_t length = strcspn(word, " \n");
+        if (column > indent && column + 1 + length >= width) {
+            Argparser_append(buffer, "\n", 1);
+            Argparser_appendSpaces(buffer, indent);
+            column = indent;
+        } else if (column > indent) {
+            Argparser_append(buffer, " ", 1);
+            column++;
+        }
+        Argparser_append(buffer, word, length);
+        column += length;
+        text = word + length;
+        while (*text == ' ')
+            text++;
+    }
+}
+
+// Columns of the placeholder, which lists the values of choices, e.g. `=<fast|slow>`.
+// Long lists count as ARGPARSER_HINT_WIDTH and move the description to the next line.
+static size_t Argparser_valueHintWidth(const ArgparserOption* option)
+{
+    if (option->type != ARGPARSER_TYPE_CHOICE)
+        return strlen(Argparser_valueHint(option));
+    size_t length = 2;
+    for (const char* const* choice = option->choices; *choice; choice++)
+        length += strlen(*choice) + 1;
+    return length < ARGPARSER_HINT_WIDTH ? length : ARGPARSER_HINT_WIDTH;
+}
+
+static void Argparser_appendValueHint(ArgparserBuffer* buffer, const ArgparserOption* option)
+{
+    if (option->type != ARGPARSER_TYPE_CHOICE) {
+        Argparser_appendString(buffer, Argparser_valueHint(option));
+        return;
+    }
+    for (const char* const* choice = option->choices; *choice; choice++) {
+        Argparser_appendString(buffer, choice == option->choices ? "=<" : "|");
+        Argparser_appendString(buffer, *choice);
+    }
+    Argparser_append(buffer, ">", 1);
+}
+
+// Renders the complete help message into one buffer
+static void Argparser_renderHelp(const ArgparserSchema* schema, size_t width, ArgparserBuffer* buffer)
+{
+    const struct ArgparserOption *options;
+
+    // print usage
+    if (schema->usage) {
+        Argparser_appendString(buffer, "Usage: ");
+        Argparser_appendString(buffer, schema->usage);
+        Argparser_append(buffer, "\n", 1);
+    }
+
+    // print description
+    if (schema->description) {
+        Argparser_appendString(buffer, schema->description);
+        Argparser_append(buffer, "\n", 1);
+    }
+
+    // figure out best width
+    size_t usage_opts_width = 0;
+    size_t len;
+    options = schema->options;
+    for (; options->type != ARGPARSER_TYPE_END; options++) {
+        len = 0;
+        if (options->shortName) {
+            len += 2;
+        }
+        if (options->shortName && options->longName) {
+            len += 2;           // separator ", "
+        }
+        if (options->longName) {
+            len += strlen(options->longName) + 2;
+        }
+
+        len += Argparser_valueHintWidth(options);
+        len = (len + 3) - ((len + 3) & 3);
+        if (usage_opts_width < len) {
+            usage_opts_width = len;
+        }
+    }
+    usage_opts_width += 4;      // 4 spaces prefix
+
+    options = schema->options;
+    for (; options->type != ARGPARSER_TYPE_END; options++) {
+        if (options->type == ARGPARSER_TYPE_GROUP) {
+            Argparser_append(buffer, "\n", 1);
+            Argparser_appendString(buffer, options->help);
+            Argparser_append(buffer, "\n", 1);
+            continue;
+        }
+        size_t lineStart = buffer->length;
+        Argparser_appendString(buffer, "    ");
+        if (options->shortName) {
+            char name[2] = { '-', options->shortName };
+            Argparser_append(buffer, name, 2);
+        }
+        if (options->longName && options->shortName) {
+            Argparser_appendString(buffer, ", ");
+        }
+        if (options->longName) {
+            Argparser_appendString(buffer, "--");
+            Argparser_appendString(buffer, options->longName);
+        }
+        Argparser_appendValueHint(buffer, options);
+
+        size_t pos = buffer->length - lineStart;
+        if (pos <= usage_opts_width) {
+            Argparser_appendSpaces(buffer, usage_opts_width - pos + 2);
+        } else {
+            Argparser_append(buffer, "\n", 1);
+            Argparser_appendSpaces(buffer, usage_opts_width + 2);
+        }
+        Argparser_appendWrapped(buffer, options->help, usage_opts_width + 2, width);
+        Argparser_append(buffer, "\n", 1);
+    }
+
+    // print commands
+    if (schema->commandCount) {
+        size_t commandWidth = 0;
+        for (size_t i = 0; i < schema->commandCount; i++) {
+            len = strlen(schema->commands[i].name);
+            len = (len + 3) - ((len + 3) & 3);
+            if (commandWidth < len) {
+                commandWidth = len;
+            }
+        }
+        commandWidth += 4;      // 4 spaces prefix
+
+        Argparser_appendString(buffer, "\nCommands\n");
+        for (size_t i = 0; i < schema->commandCount; i++) {
+            const ArgparserCommand* command = &schema->commands[i];
+            Argparser_appendString(buffer, "    ");
+            Argparser_appendString(buffer, command->name);
+            if (command->help) {
+                Argparser_appendSpaces(buffer, commandWidth - 4 - strlen(command->name) + 2);
+                Argparser_appendWrapped(buffer, command->help, commandWidth + 2, width);
+            }
+            Argparser_append(buffer, "\n", 1);
+        }
+    }
+
+    // print epilog
+    if (schema->epilog) {
+        Argparser_append(buffer, "\n", 1);
+        Argparser_appendString(buffer, schema->epilog);
+        Argparser_append(buffer, "\n", 1);
+    }
+}
+
+// Renders the help of an own schema unless it is cached for this terminal width
+static void Argparser_updateHelp(Argparser* self, size_t width)
+{
+    ArgparserSchema* schema = self->ownSchema;
+    if (!schema || self->schema != schema || schema->shared || (schema->help && schema->helpWidth == width))
+        return;
+
+    ArgparserBuffer buffer = { schema->help, 0, schema->helpCapacity };
+    Argparser_renderHelp(schema, width, &buffer);
+    schema->help = buffer.data;
+    schema->helpLength = buffer.length;
+    schema->helpCapacity = buffer.capacity;
+    schema->helpWidth = width;
+}
+
+static void Argparser_invalidateHelp(ArgparserSchema* schema)
+{
+    schema->helpWidth = 0;
+    ARGPARSER_FREE(schema->help);
+    schema->help = NULL;
+    schema->helpCapacity = 0;
+}
+
+static void Argparser_writeOut(int fd, const char* data, size_t length)
+{
+    if (fd == 1)
+        fflush(stdout);     // Keep the order of previous output
+    while (length > 0) {
+#ifdef _WIN32
+        int written = _write(fd, data, (unsigned)length);
+#else
+        ssize_t written = write(fd, data, length);
+#endif
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return;
+        data += written;
+        length -= written;
+    }
+}
+
+void Argparser_usage(Argparser* self)
+{
+    size_t width = Argparser_terminalWidth();
+    Argparser_updateHelp(self, width);
+
+    const ArgparserSchema* schema = self->schema;
+    if (schema->help && (schema->helpWidth == width || !schema->helpWidth)) {
+        Argparser_writeOut(1, schema->help, schema->helpLength);
+    } else {
+        // Shared schemas are read-only, so other widths and commands that were never rendered are rendered here
+        ArgparserBuffer buffer = { NULL, 0, 0 };
+        Argparser_renderHelp(self->schema, width, &buffer);
+        Argparser_writeOut(1, buffer.data, buffer.length);
+        ARGPARSER_FREE(buffer.data);
+    }
+}
+
+// Writes `-s`/`--long`, `-s`, or `--long` into the buffer
+static const char* Argparser_optionName(const ArgparserOption* option, char* buffer, size_t size)
+{
+    if (option->shortName && option->longName)
+        snprintf(buffer, size, "`-%c`/`--%s`", option->shortName, option->longName);
+    else if (option->shortName)
+        snprintf(buffer, size, "`-%c`", option->shortName);
+    else
+        snprintf(buffer, size, "`--%s`", option->longName);
+    return buffer;
+}
+
+// Reports an error to Argparser_tryParse and returns to it, or prints the error and exits
+static void Argparser_fail(Argparser* self, enum ArgparserErrorCode code,
+    const ArgparserOption* option, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    if (!self->error) {
+        fprintf(stderr, "error: ");
+        if (self->sourceName && self->sourceLine)
+            fprintf(stderr, "%s:%zu: ", self->sourceName, self->sourceLine);
+        else if (self->sourceName)
+            fprintf(stderr, "%s: ", self->sourceName);
+        vfprintf(stderr, format, args);
+        fputc('\n', stderr);
+        exit(1);
+    }
+
+    ArgparserError* error = self->error;
+    error->code = code;
+    error->index = self->argv ? (int)(self->indexBase + (self->argv - self->out)) : -1;
+    error->option = option;
+    if (error->message && error->messageSize) {
+        int length = !self->sourceName ? 0 : self->sourceLine
+            ? snprintf(error->message, error->messageSize, "%s:%zu: ", self->sourceName, self->sourceLine)
+            : snprintf(error->message, error->messageSize, "%s: ", self->sourceName);
+        if (length >= 0 && (size_t)length < error->messageSize)
+            vsnprintf(error->message + length, error->messageSize - length, format, args);
+    }
+    self->sourceName = NULL;
+    va_end(args);
+    longjmp(*(jmp_buf*)self->errorJump, 1);
+}
+
+void Argparser_exitForHelp(Argparser* self, const ArgparserOption* option)
+{
+    if (self->error)
+        Argparser_fail(self, ARGPARSER_ERROR_HELP, option, "help requested");
+
+    Argparser_usage(self);
+    exit(0);
+}
+
+void Argparser_exitDueToUnknownOption(Argparser* self)
+{
+    if (self->error)
+        Argparser_fail(self, ARGPARSER_ERROR_UNKNOWN_OPTION, NULL, "unknown option `%s`", self->argv[0]);
+
+    fprintf(stderr, "error: unknown option `%s`\n", self->argv[0]);
+    Argparser_usage(self);
+    exit(1);
+}
+
+void Argparser_exitDueToError(Argparser* self, const ArgparserOption* option, const char* reason)
+{
+    char name[64];
+    Argparser_optionName(option, name, sizeof(name));
+    Argparser_fail(self, ARGPARSER_ERROR_INVALID_VALUE, option, "option %s %s", name, reason);
+}
+
+// Parses digits with strtol's base prefixes, `end` receives the first character after them
+static const char* Argparser_parseUnsigned(const char* text, const char** end, uint64_t* value)
+{
+    unsigned base = 10;
+    if (text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        base = 16;
+        text += 2;
+    } else if (text[0] == '0' && text[1] >= '0' && text[1] <= '9') {
+        base = 8;
+        text++;
+    }
+
+    const char* c = text;
+    uint64_t result = 0;
+    for (;; c++) {
+        unsigned digit;
+        if (*c >= '0' && *c <= '9')
+            digit = *c - '0';
+        else if (*c >= 'a' && *c <= 'f')
+            digit = *c - 'a' + 10;
+        else if (*c >= 'A' && *c <= 'F')
+            digit = *c - 'A' + 10;
+        else
+            break;
+        if (digit >= base)
+            break;
+        if (result > (UINT64_MAX - digit) / base)
+            return "value out of range";
+        result = result * base + digit;
+    }
+    if (c == text)
+        return "expects an integer value";
+
+    *end = c;
+    *value = result;
+    return NULL;
+}
+
+const char* Argparser_toInt64(const char* text, int64_t* value)
+{
+    bool negative = text[0] == '-';
+    if (text[0] == '-' || text[0] == '+')
+        text++;
+
+    uint64_t magnitude;
+    const char* end;
+    const char* reason = Argparser_parseUnsigned(text, &end, &magnitude);
+    if (reason)
+        return reason;
+    if (*end != '\0')
+        return "expects an integer value";
+    if (magnitude > (uint64_t)INT64_MAX + negative)
+        return "value out of range";
+
+    *value = negative ? -(int64_t)(magnitude - 1) - 1 : (int64_t)magnitude;
+    return NULL;
+}
+
+const char* Argparser_toUint64(const char* text, uint64_t* value)
+{
+    if (text[0] == '+')
+        text++;
+
+    const char* end;
+    const char* reason = Argparser_parseUnsigned(text, &end, value);
+    if (reason)
+        return reason;
+    if (*end != '\0')
+        return "expects an unsigned integer value";
+    return NULL;
+}
+
+const char* Argparser_toSize(const char* text, size_t* value)
+{
+    uint64_t magnitude;
+    const char* c;
+    const char* reason = Argparser_parseUnsigned(text, &c, &magnitude);
+    if (reason)
+        return reason;
+
+    static const char units[] = "KMGTP";
+    const char* unit = *c ? strchr(units, *c == 'k' ? 'K' : *c) : NULL;
+    uint64_t factor = 1;
+    if (unit) {
+        uint64_t base = 1000;
+        if (*++c == 'i') {
+            base = 1024;
+            c++;
+        }
+        for (const char* u = units; u <= unit; u++)
+            factor *= base;
+    }
+    if (*c == 'B')
+        c++;
+    if (*c != '\0')
+        return "expects a size, e.g. 64K or 2Gi";
+    if (magnitude > UINT64_MAX / factor || magnitude * factor > SIZE_MAX)
+        return "value out of range";
+
+    *value = (size_t)(magnitude * factor);
+    return NULL;
+}
+
+// Correctly rounded libc conversion for inputs beyond the fast path, independent of the locale
+static const char* Argparser_toDoubleFallback(const char* text, double* value)
+{
+    char buffer[128];
+    const char* point = localeconv()->decimal_point;
+    const char* dot = strchr(text, '.');
+    if (dot && strcmp(point, ".") != 0) {
+        // Replace the dot by the decimal point of the current locale
+        size_t length = strlen(text);
+        size_t pointLength = strlen(point);
+        if (length + pointLength > sizeof(buffer))
+            return "expects a numerical value";
+        memcpy(buffer, text, dot - text);
+        memcpy(buffer + (dot - text), point, pointLength);
+        memcpy(buffer + (dot - text) + pointLength, dot + 1, length - (dot - text));
+        text = buffer;
+    }
+
+    char* end;
+    errno = 0;
+    double result = strtod(text, &end);
+    if (end == text || *end != '\0')
+        return "expects a numerical value";
+    if (errno == ERANGE && (result == HUGE_VAL || result == -HUGE_VAL))
+        return "value out of range";
+    *value = result;
+    return NULL;
+}
+
+const char* Argparser_toDouble(const char* text, double* value)
+{
+    // Powers of ten that are exact in a double
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    const char* c = text;
+    bool negative = *c == '-';
+    if (*c == '-' || *c == '+')
+        c++;
+
+    uint64_t mantissa = 0;
+    int digits = 0;             // Significant digits in the mantissa
+    int exponent = 0;
+    bool exact = true;
+    const char* start = c;
+    for (; *c >= '0' && *c <= '9'; c++) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*c - '0');
+            digits += mantissa != 0;
+        } else {
+            exponent++;
+            exact = false;
+        }
+    }
+    if (*c == '.') {
+        for (c++; *c >= '0' && *c <= '9'; c++) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*c - '0');
+                digits += mantissa != 0;
+                exponent--;
+            } else {
+                exact = false;
+            }
+        }
+    }
+    if (c == start || (c == start + 1 && *start == '.'))
+        return Argparser_toDoubleFallback(text, value);     // inf, nan, or invalid
+
+    if (*c == 'e' || *c == 'E') {
+        c++;
+        bool negativeExponent = *c == '-';
+        if (*c == '-' || *c == '+')
+            c++;
+        if (*c < '0' || *c > '9')
+            return "expects a numerical value";
+        int e = 0;
+        for (; *c >= '0' && *c <= '9'; c++) {
+            if (e < 100000)
+                e = e * 10 + (*c - '0');
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+    if (*c != '\0')
+        return Argparser_toDoubleFallback(text, value);     // e.g. hexadecimal floats
+
+    // Clinger's fast path: mantissa and power of ten are exact, so one operation rounds correctly
+    if (mantissa == 0 && exact) {
+        *value = negative ? -0.0 : 0.0;
+        return NULL;
+    }
+    if (!exact || mantissa > (1ull << 53) || exponent < -22 || exponent > 22)
+        return Argparser_toDoubleFallback(text, value);
+
+    double result = (double)mantissa;
+    result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+    *value = negative ? -result : result;
+    return NULL;
+}
+
+static const char* Argparser_toInt(const char* text, int* value)
+{
+    int64_t number;
+    const char* reason = Argparser_toInt64(text, &number);
+    if (!reason && (number < INT_MIN || number > INT_MAX))
+        reason = "value out of range";
+    if (!reason)
+        *value = (int)number;
+    return reason;
+}
+
+static const char* Argparser_toFloat(const char* text, float* value)
+{
+    double number;
+    const char* reason = Argparser_toDouble(text, &number);
+    if (!reason && isfinite(number) && isinf((float)number))
+        reason = "value out of range";
+    if (!reason)
+        *value = (float)number;
+    return reason;
+}
+
+static void Argparser_requireValue(Argparser* self, const ArgparserOption* option, const char *optvalue)
+{
+    if (!optvalue || optvalue[0] == '\0')
+        Argparser_exitDueToError(self, option, "requires a value");
+}
+
+// Records the option for the constraints, options of subcommands are not covered
+static inline void Argparser_markSeen(Argparser* self, const ArgparserOption* option)
+{
+    if (self->seen && !self->parentSchema) {
+        size_t index = option - self->schema->options;
+        self->seen[index / 64] |= (uint64_t)1 << index % 64;
+    }
+}
+
+// Reports a value that is not one of the choices, listing the valid ones
+static void Argparser_rejectChoice(Argparser* self, const ArgparserOption* option)
+{
+    char reason[256] = "expects one of";
+    size_t length = strlen(reason);
+    for (const char* const* choice = option->choices; *choice; choice++) {
+        int written = snprintf(reason + length, sizeof(reason) - length, "%s `%s`",
+            choice == option->choices ? "" : ",", *choice);
+        if (written < 0 || (size_t)written >= sizeof(reason) - length) {
+            strcpy(reason + sizeof(reason) - 5, " ...");
+            break;
+        }
+        length += written;
+    }
+    Argparser_exitDueToError(self, option, reason);
+}
+
+void Argparser_parseValue(Argparser* self, const ArgparserOption* option, const char *optvalue)
+{
+    ARGPARSER_STATS_START(start);
+    Argparser_markSeen(self, option);
+#ifdef ARGPARSER_ENABLE_STATS
+    // Options of commands have no counters, their time is measured nonetheless
+    ArgparserOptionStats ignored = { 0, 0 };
+    ArgparserOptionStats* stats = self->parentSchema ? &ignored : &self->stats.options[option - self->schema->options];
+    stats->hits++;
+#endif
+    const char *reason = NULL;
+    void *value = Argparser_getValue(self, option);
+    if (value) {
         switch (option->type) {
         case ARGPARSER_TYPE_BOOLEAN:
             if (optvalue) {
-                if(strlen(optvalue) == 1 && optvalue[0] == '1') {
-                    *(bool *)option->value = true;
-                } else if(strlen(optvalue) == 1 && optvalue[0] == '0') {
-                    *(bool *)option->value = false;
+                if (optvalue[0] == '1' && optvalue[1] == '\0') {
+                    *(bool *)value = true;
+                } else if (optvalue[0] == '0' && optvalue[1] == '\0') {
+                    *(bool *)value = false;
                 } else {
                     Argparser_exitDueToError(self, option, "expects no value, 0, or 1");
                 }
             } else
-                *(bool *)option->value = true;
+                *(bool *)value = true;
             break;
 
+        case ARGPARSER_TYPE_FLAG: {
+            uint64_t *word = (uint64_t *)value + option->bit / 64;
+            if (!optvalue || (optvalue[0] == '1' && optvalue[1] == '\0')) {
+                *word |= ARGPARSER_FLAG_MASK(option->bit);
+            } else if (optvalue[0] == '0' && optvalue[1] == '\0') {
+                *word &= ~ARGPARSER_FLAG_MASK(option->bit);
+            } else {
+                Argparser_exitDueToError(self, option, "expects no value, 0, or 1");
+            }
+            break;
+        }
+
         case ARGPARSER_TYPE_STRING:
+            if (optvalue && self->copyValues) {
+                // Streamed values are overwritten by the next chunk and config files are unmapped
+                // by the next parse, keep one copy per option
+                size_t length = strlen(optvalue) + 1;
+                struct ArgparserValueCopy* copy = &self->valueCopies[option - self->schema->options];
+                if (length > copy->capacity) {
+                    copy->text = (char*)Argparser_checkParseAllocation(self, ARGPARSER_REALLOC(copy->text, length));
+                    copy->capacity = length;
+                }
+                optvalue = (const char*)memcpy(copy->text, optvalue, length);
+            }
             if (optvalue) {
-                *(const char **)option->value = optvalue;
+                *(const char **)value = optvalue;
             } else {
                 Argparser_exitDueToError(self, option, "requires a value");
             }
             break;
 
         case ARGPARSER_TYPE_INTEGER:
-            errno = 0;
-            if (optvalue && strlen(optvalue) > 0) {
-                *(int *)option->value = strtol(optvalue, (char **)&s, 0);
-            } else {
+            Argparser_requireValue(self, option, optvalue);
+            reason = Argparser_toInt(optvalue, (int *)value);
+            break;
+
+        case ARGPARSER_TYPE_FLOAT:
+            Argparser_requireValue(self, option, optvalue);
+            reason = Argparser_toFloat(optvalue, (float *)value);
+            break;
+
+        case ARGPARSER_TYPE_INT64:
+            Argparser_requireValue(self, option, optvalue);
+            reason = Argparser_toInt64(optvalue, (int64_t *)value);
+            break;
+
+        case ARGPARSER_TYPE_UINT64:
+            Argparser_requireValue(self, option, optvalue);
+            reason = Argparser_toUint64(optvalue, (uint64_t *)value);
+            break;
+
+        case ARGPARSER_TYPE_DOUBLE:
+            Argparser_requireValue(self, option, optvalue);
+            reason = Argparser_toDouble(optvalue, (double *)value);
+            break;
+
+        case ARGPARSER_TYPE_SIZE:
+            Argparser_requireValue(self, option, optvalue);
+            reason = Argparser_toSize(optvalue, (size_t *)value);
+            break;
+
+        case ARGPARSER_TYPE_CHOICE: {
+            Argparser_requireValue(self, option, optvalue);
+            int choice = Argparser_findChoice(self->schema, option, optvalue);
+            if (choice < 0)
+                Argparser_rejectChoice(self, option);
+            *(int *)value = choice;
+            break;
+        }
+
+        case ARGPARSER_TYPE_STRING_LIST:
+            if (!optvalue)
                 Argparser_exitDueToError(self, option, "requires a value");
+            if (self->copyValues) {
+                // Streamed values are overwritten by the next chunk, config files are unmapped
+                size_t length = strlen(optvalue) + 1;
+                optvalue = (const char*)memcpy(Argparser_allocate(self, length), optvalue, length);
             }
-            if (errno)
-                Argparser_exitDueToError(self, option, strerror(errno));
-            if (s[0] != '\0')
-                Argparser_exitDueToError(self, option, "expects an integer value");
+            *(const char **)Argparser_appendToList(self, (ArgparserList *)value, sizeof(const char *)) = optvalue;
             break;
 
-        case ARGPARSER_TYPE_FLOAT:
-            errno = 0;
-            if (optvalue && strlen(optvalue) > 0) {
-                *(float *)option->value = strtof(optvalue, (char **)&s);
+        case ARGPARSER_TYPE_INTEGER_LIST: {
+            int number;
+            Argparser_requireValue(self, option, optvalue);
+            reason = Argparser_toInt(optvalue, &number);
+            if (!reason)
+                *(int *)Argparser_appendToList(self, (ArgparserList *)value, sizeof(int)) = number;
+            break;
+        }
+
+        case ARGPARSER_TYPE_FLOAT_LIST: {
+            float number;
+            Argparser_requireValue(self, option, optvalue);
+            reason = Argparser_toFloat(optvalue, &number);
+            if (!reason)
+                *(float *)Argparser_appendToList(self, (ArgparserList *)value, sizeof(float)) = number;
+            break;
+        }
+
+        default:
+            assert(0);
+        }
+    }
+
+    if (reason)
+        Argparser_exitDueToError(self, option, reason);
+    ARGPARSER_STATS_STOP(self, conversionNs, start);
+
+    if (option->callback) {
+        ARGPARSER_STATS_START(callbackStart);
+        option->callback(self, option);
+#ifdef ARGPARSER_ENABLE_STATS
+        uint64_t callbackNs = Argparser_nowNs() - callbackStart;
+        stats->callbackNs += callbackNs;
+        self->stats.callbackNs += callbackNs;
+#endif
+    }
+}
+
+// Whether a single short option takes `next` as its value. Booleans and flags only take `0` and `1`,
+// so `-b 0` clears them while `-v commit` passes `commit` on. `true` and `false` are taken too,
+// to be rejected as values instead of being passed on silently.
+static inline bool Argparser_takesNext(const ArgparserOption* option, const char* next)
+{
+    if (!next || next[0] == '-')
+        return false;
+    if (option->type != ARGPARSER_TYPE_BOOLEAN && option->type != ARGPARSER_TYPE_FLAG)
+        return true;
+    return ((next[0] == '0' || next[0] == '1') && next[1] == '\0')
+        || strcmp(next, "true") == 0 || strcmp(next, "false") == 0;
+}
+
+void Argparser_parseShortOption(Argparser* self)
+{
+    const char *arg = self->argv[0];
+    const ArgparserOption* option;
+
+    if (arg[2] == '\0') {
+        // Single options might carry a value
+        ARGPARSER_STATS_START(start);
+        option = self->schema->shortIndex[(unsigned char)arg[1]];
+        ARGPARSER_STATS_STOP(self, lookupNs, start);
+        if (!option)
+            Argparser_exitDueToUnknownOption(self);
+
+        if (self->argc > 1 && Argparser_takesNext(option, self->argv[1])) {
+            // Use next argument as a value, remove it from arguments
+            Argparser_parseValue(self, option, self->argv[1]);
+            self->argv++;
+            self->argc--;
+        } else {
+            Argparser_parseValue(self, option, NULL);
+        }
+    } else {
+        // Compound arguments are always boolean without value.
+        // Flags of the same mask word are collected and stored with a single OR.
+        uint64_t* word = NULL;
+        uint64_t bits = 0;
+        for (const char* i = arg+1; *i != '\0'; i++) {
+            ARGPARSER_STATS_START(start);
+            option = self->schema->shortIndex[(unsigned char)*i];
+            ARGPARSER_STATS_STOP(self, lookupNs, start);
+            if (!option)
+                Argparser_exitDueToUnknownOption(self);
+
+            if (option->type == ARGPARSER_TYPE_FLAG && option->value && !option->callback) {
+                uint64_t* target = (uint64_t*)Argparser_getValue(self, option) + option->bit / 64;
+                if (target != word) {
+                    if (word)
+                        *word |= bits;
+                    word = target;
+                    bits = 0;
+                }
+                bits |= ARGPARSER_FLAG_MASK(option->bit);
+                Argparser_markSeen(self, option);
+#ifdef ARGPARSER_ENABLE_STATS
+                if (!self->parentSchema)
+                    self->stats.options[option - self->schema->options].hits++;
+#endif
+                continue;
+            }
+            // Keep the order for other options, their callbacks may read the flags
+            if (word) {
+                *word |= bits;
+                word = NULL;
+            }
+            Argparser_parseValue(self, option, NULL);
+        }
+        if (word)
+            *word |= bits;
+    }
+}
+
+// Resolves a unique prefix of a long name, fails if the prefix is ambiguous
+static const ArgparserOption* Argparser_findAbbreviation(Argparser* self, const char* name, size_t length)
+{
+    const ArgparserSchema* schema = self->schema;
+    const ArgparserTrieNode* node = Argparser_findPrefix(schema, name, length);
+    if (!node)
+        return NULL;
+    if (node->count == 1)
+        return &schema->options[schema->prefixOrder[node->first]];
+
+    // List the candidates without allocating, long lists are cut off
+    char candidates[256];
+    size_t used = 0;
+    for (uint32_t i = 0; i < node->count; i++) {
+        const char* candidate = schema->options[schema->prefixOrder[node->first + i]].longName;
+        size_t needed = strlen(candidate) + 6;
+        if (used + needed + 4 >= sizeof(candidates)) {
+            strcpy(candidates + used, i ? ", ..." : "...");
+            break;
+        }
+        used += snprintf(candidates + used, sizeof(candidates) - used, "%s`--%s`", i ? ", " : "", candidate);
+    }
+    Argparser_fail(self, ARGPARSER_ERROR_AMBIGUOUS_OPTION, NULL,
+        "option `--%.*s` is ambiguous, candidates are %s", (int)length, name, candidates);
+    return NULL;
+}
+
+void Argparser_parseLongOption(Argparser* self)
+{
+    // Hash the name up to a potential `=value` in a single pass
+    ARGPARSER_STATS_START(start);
+    const char *name = self->argv[0] + 2;
+    const char *rest = name;
+    uint32_t hash = ARGPARSER_HASH_INIT;
+    for (; *rest != '\0' && *rest != '='; rest++)
+        hash = ARGPARSER_HASH_STEP(hash, *rest);
+
+    const ArgparserOption* option = Argparser_findLongOption(self->schema, name, rest - name, hash);
+    if (!option && self->schema->abbreviations && self->schema->prefixTrie && rest != name)
+        option = Argparser_findAbbreviation(self, name, rest - name);
+    ARGPARSER_STATS_STOP(self, lookupNs, start);
+    if (!option)
+        Argparser_exitDueToUnknownOption(self);
+
+    // Set the value of the current option
+    if (*rest == '=') {
+        Argparser_parseValue(self, option, rest+1);
+    } else if (option->type == ARGPARSER_TYPE_BOOLEAN || option->type == ARGPARSER_TYPE_FLAG) {
+        // There is no value; Only accept this for boolean
+        Argparser_parseValue(self, option, NULL);
+    } else {
+        Argparser_exitDueToUnknownOption(self);
+    }
+}
+
+#define ARGPARSER_MAX_RESPONSE_DEPTH 32
+
+static void Argparser_pushArgument(Argparser* self, const char* argument)
+{
+    if (self->expandedCount == self->expandedCapacity) {
+        int capacity = self->expandedCapacity ? 2 * self->expandedCapacity : 64;
+        self->expanded = (const char**)Argparser_checkParseAllocation(self,
+            ARGPARSER_REALLOC(self->expanded, capacity * sizeof(*self->expanded)));
+        self->expandedCapacity = capacity;
+    }
+    self->expanded[self->expandedCount++] = argument;
+}
+
+// Keeps a loaded file until the next parse, as arguments point into it
+static void Argparser_keepFile(Argparser* self, const ArgparserFile* file)
+{
+    if (self->fileCount == self->fileCapacity) {
+        int capacity = self->fileCapacity ? 2 * self->fileCapacity : 4;
+        ArgparserFile* files = (ArgparserFile*)ARGPARSER_REALLOC(self->files, capacity * sizeof(*self->files));
+        if (!files) {
+            Argparser_releaseFile(file);
+            Argparser_fail(self, ARGPARSER_ERROR_MEMORY, NULL, "out of memory");
+        }
+        self->files = files;
+        self->fileCapacity = capacity;
+    }
+    self->files[self->fileCount++] = *file;
+}
+
+static void Argparser_expandArgument(Argparser* self, const char* argument, uint64_t (*ids)[2], int depth)
+{
+    if (argument[0] != '@' || !argument[1] || self->expansionStopped) {
+        if (strcmp(argument, "--") == 0)
+            self->expansionStopped = true;
+        Argparser_pushArgument(self, argument);
+        return;
+    }
+
+    ArgparserFile file;
+    if (!Argparser_openFile(argument + 1, &file, ids[depth])) {
+        Argparser_pushArgument(self, argument);     // Keep unreadable files as arguments, like GCC
+        return;
+    }
+    Argparser_keepFile(self, &file);
+
+    for (int i = 0; i < depth; i++) {
+        if (ids[i][0] == ids[depth][0] && ids[i][1] == ids[depth][1])
+            Argparser_fail(self, ARGPARSER_ERROR_RESPONSE_FILE, NULL, "response file `%s` includes itself", argument + 1);
+    }
+    if (depth + 1 == ARGPARSER_MAX_RESPONSE_DEPTH)
+        Argparser_fail(self, ARGPARSER_ERROR_RESPONSE_FILE, NULL, "response file `%s` is nested too deeply", argument + 1);
+
+    // The tokens are packed at the start of the file, each followed by a terminator
+    int count = Argparser_tokenize(file.data, file.size, file.data, NULL, 0);
+    if (count < 0)
+        Argparser_fail(self, ARGPARSER_ERROR_RESPONSE_FILE, NULL, "response file `%s` ends within quotes", argument + 1);
+    const char* token = file.data;
+    for (int i = 0; i < count; i++) {
+        Argparser_expandArgument(self, token, ids, depth + 1);
+        token += strlen(token) + 1;
+    }
+}
+
+// Replaces argc/argv by the expanded arguments if any `@file` is given
+static void Argparser_expandResponseFiles(Argparser* self, int* argc, const char*** argv)
+{
+    int i = 1;
+    for (; i < *argc; i++) {
+        if ((*argv)[i][0] == '@' || strcmp((*argv)[i], "--") == 0)
+            break;
+    }
+    if (i == *argc || (*argv)[i][0] != '@')
+        return;
+
+    uint64_t ids[ARGPARSER_MAX_RESPONSE_DEPTH][2];
+    self->expandedCount = 0;
+    self->expansionStopped = false;
+    self->out = *argv;
+    Argparser_pushArgument(self, (*argv)[0]);
+    for (i = 1; i < *argc; i++) {
+        self->argv = *argv + i;     // Reported as position of errors
+        Argparser_expandArgument(self, (*argv)[i], ids, 0);
+    }
+    Argparser_pushArgument(self, NULL);
+
+    *argc = self->expandedCount - 1;
+    *argv = self->expanded;
+}
+
+// Collects the current argument as remaining argument, or its position
+static inline void Argparser_keepArgument(Argparser* self)
+{
+    if (!self->positions)
+        self->out[self->cpidx] = self->argv[0];
+    else if (self->cpidx < self->positionCapacity)
+        self->positions[self->cpidx] = (int)(self->argv - self->out);
+    self->cpidx++;
+}
+
+// Parses options up to the end of the arguments or `--`. Other arguments are collected,
+// or stop parsing if `stopAtNonOption` is set; returns true in this case.
+static bool Argparser_parseOptions(Argparser* self, bool stopAtNonOption)
+{
+    for (; self->argc; self->argc--, self->argv++) {
+        const char *arg = self->argv[0];
+        if (arg[0] != '-' || !arg[1]) {
+            if (stopAtNonOption) {
+                return true;    // Finished, exit loop
+            }
+            // If it's not option or a single char '-', copy verbatim
+            Argparser_keepArgument(self);
+            continue;
+        }
+
+        // Check if it is a short option
+        if (arg[1] != '-') {
+            Argparser_parseShortOption(self);
+        } else {
+            // Check if it is a long option
+            if (arg[2]) {
+                Argparser_parseLongOption(self);
             } else {
-                Argparser_exitDueToError(self, option, "requires a value");
+                // It is --, stop argument parsing
+                self->argc--;
+                self->argv++;
+                break;       // Finished, exit loop
             }
-            if (errno)
-                Argparser_exitDueToError(self, option, strerror(errno));
-            if (s[0] != '\0')
-                Argparser_exitDueToError(self, option, "expects a numerical value");
-            break;
-        default:
-            assert(0);
         }
     }
+    return false;
+}
 
-    if (option->callback) {
-        option->callback(self, option);
+// Returns the schema of a command of `parent`, compiled on its first use. Shared schemas
+// were compiled completely by Argparser_getSchema, so only owned schemas are modified here.
+static const ArgparserSchema* Argparser_getCommandSchema(const ArgparserSchema* parent,
+    const ArgparserCommand* command)
+{
+    size_t c = (size_t)(command - parent->commands);
+    if (!parent->commandSchemas[c])
+        Argparser_compileCommand((ArgparserSchema*)parent, c);
+    return parent->commandSchemas[c];
+}
+
+// Selects the command named by the current argument and parses the following arguments with its options
+static void Argparser_parseCommand(Argparser* self)
+{
+    const ArgparserSchema* parent = self->schema;
+    const ArgparserCommand* command = Argparser_findCommand(parent, self->argv[0]);
+    if (!command)
+        Argparser_fail(self, ARGPARSER_ERROR_UNKNOWN_COMMAND, NULL, "unknown command `%s`", self->argv[0]);
+    const ArgparserSchema* schema = Argparser_getCommandSchema(parent, command);
+
+    self->command = command;
+    self->parentSchema = parent;
+    self->schema = schema;
+    self->argc--;
+    self->argv++;
+    Argparser_parseOptions(self, schema->stopAtNonOption);
+    self->schema = parent;
+    self->parentSchema = NULL;
+}
+
+// Appends the long options starting with `prefix` in sorted order, values are started with `=`
+static void Argparser_appendLongCandidates(ArgparserBuffer* buffer, const ArgparserSchema* schema,
+    const char* prefix, size_t length)
+{
+    const ArgparserTrieNode* node = schema->prefixTrie ? Argparser_findPrefix(schema, prefix, length) : NULL;
+    for (uint32_t i = 0; node && i < node->count; i++) {
+        const ArgparserOption* option = &schema->options[schema->prefixOrder[node->first + i]];
+        Argparser_append(buffer, "--", 2);
+        Argparser_appendString(buffer, option->longName);
+        bool boolean = option->type == ARGPARSER_TYPE_BOOLEAN || option->type == ARGPARSER_TYPE_FLAG;
+        Argparser_appendString(buffer, boolean ? "\n" : "=\n");
     }
 }
 
-void Argparser_parseShortOption(Argparser* self, const ArgparserOption* options)
+// Answers `--__complete <word>... <partial>` and exits
+static void Argparser_complete(Argparser* self, int count, const char** words)
 {
-    bool foundOption = false;
+    const ArgparserSchema* schema = self->schema;
+    const char* partial = count > 0 ? words[count - 1] : "";
+    bool commandExpected = schema->commandCount > 0;
+    bool optionsEnded = false;
 
-    const char *arg = self->argv[0];
-    if (strlen(arg) == 2)
-    {
-        // Single options might carry a value
-        for (; options->type != ARGPARSER_TYPE_END; options++) {
-            if (options->shortName != 0 && options->shortName == *(self->argv[0]+1)) {
-                if (self->argc > 1 && self->argv[1] && self->argv[1][0] != '-') {
-                    // Use next argument as a value, remove it from arguments
-                    Argparser_parseValue(self, options, self->argv[1]);
-                    self->argv++;
-                    self->argc--;
-                    foundOption = true;
-                } else {
-                    Argparser_parseValue(self, options, NULL);
-                    foundOption = true;
+    // Follow the preceding words like the parser: the first non-option selects the command
+    for (int i = 0; i < count - 1 && !optionsEnded; i++) {
+        const char* word = words[i];
+        if (strcmp(word, "--") == 0) {
+            optionsEnded = true;
+        } else if (word[0] == '-' && word[1]) {
+            // Single short options may take the next argument as value
+            const ArgparserOption* option = word[1] != '-' && word[2] == '\0'
+                ? schema->shortIndex[(unsigned char)word[1]] : NULL;
+            if (option && i + 1 < count - 1 && Argparser_takesNext(option, words[i + 1]))
+                i++;
+        } else if (commandExpected) {
+            const ArgparserCommand* command = Argparser_findCommand(schema, word);
+            if (!command)
+                exit(0);
+            schema = Argparser_getCommandSchema(schema, command);
+            commandExpected = false;
+        } else if (schema->stopAtNonOption) {
+            optionsEnded = true;
+        }
+    }
+
+    ArgparserBuffer buffer = { NULL, 0, 0 };
+    size_t length = strlen(partial);
+    if (optionsEnded) {
+        // Only arguments follow, leave them to the shell
+    } else if (partial[0] == '-' && partial[1] == '-') {
+        if (!strchr(partial, '='))
+            Argparser_appendLongCandidates(&buffer, schema, partial + 2, length - 2);
+    } else if (partial[0] == '-') {
+        if (!partial[1]) {
+            for (int c = 0; c < 256; c++) {
+                if (schema->shortIndex[c]) {
+                    char name[3] = { '-', (char)c, '\n' };
+                    Argparser_append(&buffer, name, 3);
                 }
             }
+            Argparser_appendLongCandidates(&buffer, schema, "", 0);
+        }
+    } else if (commandExpected) {
+        for (size_t i = 0; i < schema->commandCount; i++) {
+            if (strncmp(schema->commands[i].name, partial, length) == 0) {
+                Argparser_appendString(&buffer, schema->commands[i].name);
+                Argparser_append(&buffer, "\n", 1);
+            }
         }
+    }
+    Argparser_writeOut(1, buffer.data, buffer.length);
+    ARGPARSER_FREE(buffer.data);
+    exit(0);
+}
+
+bool Argparser_writeCompletionScript(const char* program, const char* shell, int fd)
+{
+    // Shell functions are named after the program, without its path and with safe characters only
+    const char* slash = strrchr(program, '/');
+    program = slash ? slash + 1 : program;
+    char function[128];
+    size_t i = 0;
+    for (; program[i] && i < sizeof(function) - 1; i++) {
+        char c = program[i];
+        bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+        function[i] = safe ? c : '_';
+    }
+    function[i] = '\0';
+
+    char script[1024];
+    int length;
+    if (strcmp(shell, "bash") == 0) {
+        length = snprintf(script, sizeof(script),
+            "_%s_complete() {\n"
+            "    local IFS=$'\\n'\n"
+            "    COMPREPLY=($(\"$1\" --__complete \"${COMP_WORDS[@]:1:COMP_CWORD}\" 2>/dev/null))\n"
+            "    [[ ${#COMPREPLY[@]} -eq 1 && $COMPREPLY == *= ]] && compopt -o nospace\n"
+            "}\n"
+            "complete -o default -F _%s_complete %s\n",
+            function, function, program);
+    } else if (strcmp(shell, "zsh") == 0) {
+        length = snprintf(script, sizeof(script),
+            "#compdef %s\n"
+            "_%s_complete() {\n"
+            "    local -a candidates\n"
+            "    candidates=(${(f)\"$(${words[1]} --__complete \"${(@)words[2,CURRENT]}\" 2>/dev/null)\"})\n"
+            "    (( ${#candidates} )) || { _files; return }\n"
+            "    compadd -S '' -- ${(M)candidates:#*=}\n"
+            "    compadd -- ${candidates:#*=}\n"
+            "}\n"
+            "compdef _%s_complete %s\n",
+            program, function, function, program);
+    } else if (strcmp(shell, "fish") == 0) {
+        length = snprintf(script, sizeof(script),
+            "complete -c %s -a '(%s --__complete (commandline -opc)[2..-1] (commandline -ct))'\n",
+            program, program);
     } else {
-        // Compound arguments are always boolean without value
-        for (const char* i = arg+1; *i != '\0'; i++) {
-            foundOption = false;
-            const ArgparserOption* optIterator = options;
+        return false;
+    }
+    Argparser_writeOut(fd, script, (size_t)length < sizeof(script) ? (size_t)length : sizeof(script) - 1);
+    return true;
+}
 
-            for (; optIterator->type != ARGPARSER_TYPE_END; optIterator++) {
-                if (optIterator->shortName == *i) {
-                    Argparser_parseValue(self, optIterator, NULL);
-                    foundOption = true;
-                }
+// Clears the record of given options before a parse
+static void Argparser_resetSeen(Argparser* self)
+{
+    size_t words = (self->schema->optionCount + 63) / 64;
+    if (!self->seen)
+        self->seen = (uint64_t*)Argparser_checkParseAllocation(self, ARGPARSER_MALLOC(2 * words * sizeof(uint64_t)));
+    memset(self->seen, 0, words * sizeof(uint64_t));
+    if (self->configLines)
+        memset(self->configLines, 0, self->schema->optionCount * sizeof(size_t));
+}
+
+static inline bool Argparser_isSeen(const Argparser* self, uint32_t index)
+{
+    return (self->seen[index / 64] >> index % 64) & 1;
+}
+
+// Remembers the options given so far, e.g. on the command line, before values of a lower precedence are applied
+static const uint64_t* Argparser_snapshotSeen(Argparser* self)
+{
+    size_t words = (self->schema->optionCount + 63) / 64;
+    return (const uint64_t*)memcpy(self->seen + words, self->seen, words * sizeof(uint64_t));
+}
+
+// Finds the long option `section-key`, or `key` without a section
+static const ArgparserOption* Argparser_findConfigOption(const ArgparserSchema* self,
+    const char* section, size_t sectionLength, const char* key, size_t keyLength)
+{
+    uint32_t hash = ARGPARSER_HASH_INIT;
+    for (size_t i = 0; i < sectionLength; i++)
+        hash = ARGPARSER_HASH_STEP(hash, section[i]);
+    if (sectionLength)
+        hash = ARGPARSER_HASH_STEP(hash, '-');
+    for (size_t i = 0; i < keyLength; i++)
+        hash = ARGPARSER_HASH_STEP(hash, key[i]);
+    if (!sectionLength)
+        return Argparser_findLongOption(self, key, keyLength, hash);
+
+    uint32_t i = hash & self->longIndexMask;
+    for (; self->longIndex[i].option; i = (i + 1) & self->longIndexMask) {
+        const ArgparserOption* option = self->options + self->longIndex[i].option - 1;
+        const char* name = option->longName;
+        if (self->longIndex[i].hash == hash
+            && strncmp(name, section, sectionLength) == 0 && name[sectionLength] == '-'
+            && strncmp(name + sectionLength + 1, key, keyLength) == 0 && name[sectionLength + 1 + keyLength] == '\0')
+            return option;
+    }
+    return NULL;
+}
+
+// Parses a value of a config file or the environment, where booleans may also be words
+static void Argparser_parseSetting(Argparser* self, const ArgparserOption* option, const char* value)
+{
+    if (option->type == ARGPARSER_TYPE_BOOLEAN || option->type == ARGPARSER_TYPE_FLAG) {
+        if (!*value || !strcmp(value, "true") || !strcmp(value, "yes") || !strcmp(value, "on"))
+            value = "1";
+        else if (!strcmp(value, "false") || !strcmp(value, "no") || !strcmp(value, "off"))
+            value = "0";
+    }
+    Argparser_parseValue(self, option, value);
+}
+
+// Copies the following string values, e.g. of a stream, until copyValues is cleared
+static void Argparser_prepareCopies(Argparser* self)
+{
+    if (!self->valueCopies)
+        self->valueCopies = (struct ArgparserValueCopy*)Argparser_checkParseAllocation(self,
+            ARGPARSER_CALLOC(self->schema->optionCount, sizeof(struct ArgparserValueCopy)));
+    self->copyValues = true;
+}
+
+static inline bool Argparser_isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Applies the config file to the options that were not given on the command line
+static void Argparser_applyConfigFile(Argparser* self, const char* path)
+{
+    ArgparserFile file;
+    uint64_t id[2];
+    self->argv = NULL;      // Errors refer to the file instead
+    if (!Argparser_openFile(path, &file, id))
+        Argparser_fail(self, ARGPARSER_ERROR_CONFIG, NULL, "cannot read config file `%s`", path);
+    Argparser_keepFile(self, &file);
+    file.data[file.size] = '\0';
+    Argparser_prepareCopies(self);
+    if (!self->configLines)
+        self->configLines = (size_t*)Argparser_checkParseAllocation(self,
+            ARGPARSER_CALLOC(self->schema->optionCount, sizeof(size_t)));
+
+    const uint64_t* given = Argparser_snapshotSeen(self);
+    const char* section = NULL;
+    size_t sectionLength = 0;
+    char* end = file.data + file.size;
+    self->sourceName = path;
+    self->sourceLine = 0;
+    for (char* line = file.data; line < end; ) {
+        // Values are terminated in place, at the newline or behind their last character
+        char* lineEnd = (char*)memchr(line, '\n', end - line);
+        lineEnd = lineEnd ? lineEnd : end;
+        char* next = lineEnd + 1;
+        self->sourceLine++;
+        while (line < lineEnd && Argparser_isBlank(*line))
+            line++;
+        while (lineEnd > line && Argparser_isBlank(lineEnd[-1]))
+            lineEnd--;
+
+        if (line == lineEnd || *line == '#' || *line == ';') {
+            // Empty line or comment
+        } else if (*line == '[') {
+            if (lineEnd[-1] != ']' || lineEnd - line < 2)
+                Argparser_fail(self, ARGPARSER_ERROR_CONFIG, NULL, "expected `[section]`");
+            section = line + 1;
+            sectionLength = lineEnd - line - 2;
+        } else {
+            char* equals = (char*)memchr(line, '=', lineEnd - line);
+            if (!equals)
+                Argparser_fail(self, ARGPARSER_ERROR_CONFIG, NULL, "expected `key = value`");
+            char* keyEnd = equals;
+            while (keyEnd > line && Argparser_isBlank(keyEnd[-1]))
+                keyEnd--;
+            char* value = equals + 1;
+            while (value < lineEnd && Argparser_isBlank(*value))
+                value++;
+            if (lineEnd - value >= 2 && (*value == '"' || *value == '\'') && lineEnd[-1] == *value) {
+                value++;
+                lineEnd--;
             }
-            if (!foundOption) {
-                Argparser_exitDueToUnknownOption(self);
+            *lineEnd = '\0';
+
+            const ArgparserOption* option = Argparser_findConfigOption(self->schema, section, sectionLength, line, keyEnd - line);
+            if (!option)
+                Argparser_fail(self, ARGPARSER_ERROR_CONFIG, NULL, "unknown option `%.*s%s%.*s`",
+                    (int)sectionLength, section ? section : "", sectionLength ? "-" : "", (int)(keyEnd - line), line);
+
+            uint32_t index = (uint32_t)(option - self->schema->options);
+            if (!((given[index / 64] >> index % 64) & 1)) {
+                self->configLines[index] = self->sourceLine;
+                Argparser_parseSetting(self, option, value);
             }
         }
+        line = next;
     }
+    self->sourceName = NULL;
+    self->copyValues = false;
+}
 
-    if (!foundOption) {
-        Argparser_exitDueToUnknownOption(self);
+// Converts the name of an option into a variable name, e.g. `dry-run` into `DRY_RUN`
+static inline char Argparser_envChar(char c)
+{
+    return c == '-' ? '_' : c >= 'a' && c <= 'z' ? (char)(c - 'a' + 'A') : c;
+}
+
+// Hashes the variables of the environment by name, the first of duplicate names is found first like by getenv
+static void Argparser_indexEnvironment(Argparser* self, char** environment)
+{
+    size_t count = 0;
+    while (environment && environment[count])
+        count++;
+    uint32_t size = 16;
+    while (size < 2 * count)
+        size <<= 1;
+    if (!self->envIndex || size > self->envIndexMask + 1) {
+        ArgparserIndexSlot* index = (ArgparserIndexSlot*)Argparser_checkParseAllocation(self,
+            ARGPARSER_MALLOC(size * sizeof(ArgparserIndexSlot)));
+        ARGPARSER_FREE(self->envIndex);
+        self->envIndex = index;
+        self->envIndexMask = size - 1;
+    }
+    memset(self->envIndex, 0, (self->envIndexMask + 1) * sizeof(ArgparserIndexSlot));
+
+    for (size_t v = 0; v < count; v++) {
+        uint32_t hash = ARGPARSER_HASH_INIT;
+        for (const char* c = environment[v]; *c && *c != '='; c++)
+            hash = ARGPARSER_HASH_STEP(hash, *c);
+        uint32_t i = hash & self->envIndexMask;
+        while (self->envIndex[i].option)
+            i = (i + 1) & self->envIndexMask;
+        self->envIndex[i].hash = hash;
+        self->envIndex[i].option = (uint32_t)v + 1;
     }
 }
 
-void Argparser_parseLongOption(Argparser* self, const ArgparserOption* options)
+// Finds the variable `prefix` followed by `name`, which is converted like a long name if `convert` is set.
+// Returns the `NAME=value` entry or NULL.
+static const char* Argparser_findEnvironment(const Argparser* self, char** environment,
+    const char* prefix, const char* name, bool convert)
 {
-    bool foundOption = false;
+    uint32_t hash = ARGPARSER_HASH_INIT;
+    for (const char* c = prefix; *c; c++)
+        hash = ARGPARSER_HASH_STEP(hash, *c);
+    for (const char* c = name; *c; c++)
+        hash = ARGPARSER_HASH_STEP(hash, convert ? Argparser_envChar(*c) : *c);
 
-    for (; options->type != ARGPARSER_TYPE_END; options++) {
-        if (!options->longName || strlen(options->longName) < 1)
+    uint32_t i = hash & self->envIndexMask;
+    for (; self->envIndex[i].option; i = (i + 1) & self->envIndexMask) {
+        if (self->envIndex[i].hash != hash)
+            continue;
+        const char* entry = environment[self->envIndex[i].option - 1];
+        const char* c = prefix;
+        while (*c && *entry == *c)
+            c++, entry++;
+        if (*c)
             continue;
+        for (c = name; *c && *entry == (convert ? Argparser_envChar(*c) : *c); c++)
+            entry++;
+        if (!*c && *entry == '=')
+            return environment[self->envIndex[i].option - 1];
+    }
+    return NULL;
+}
 
-        // Check if the option matches current name
-        size_t nameLength = strlen(options->longName);
-        const char *rest = strncmp(self->argv[0] + 2, options->longName, nameLength) ?
-            NULL : self->argv[0] + 2 + nameLength;
+// Applies the environment variables to the options that were not given on the command line.
+// Runs after Argparser_parseCommand restored the main schema, so options of commands are not covered.
+static void Argparser_applyEnvironment(Argparser* self)
+{
+    const ArgparserSchema* schema = self->schema;
+    char** environment = ARGPARSER_ENVIRON;
+    Argparser_indexEnvironment(self, environment);
+    const uint64_t* given = Argparser_snapshotSeen(self);
+    self->argv = NULL;
+    for (uint32_t index = 0; index < schema->optionCount; index++) {
+        const ArgparserOption* option = &schema->options[index];
+        const char* entry = NULL;
+        if ((given[index / 64] >> index % 64) & 1)
+            continue;
+        if (option->env)
+            entry = Argparser_findEnvironment(self, environment, "", option->env, false);
+        else if (schema->envPrefix && option->longName && option->value)
+            entry = Argparser_findEnvironment(self, environment, schema->envPrefix, option->longName, true);
+        if (!entry)
+            continue;
 
-        if (rest) {
-            // Set the value of the current option
-            if (*rest == '=') {
-                Argparser_parseValue(self, options, rest+1);
-                foundOption = true;
-            } else {
-                // There is no value; Only accept this for boolean or skip
-                if (options->type == ARGPARSER_TYPE_BOOLEAN) {
-                    Argparser_parseValue(self, options, NULL);
-                    foundOption = true;
+        const char* value = strchr(entry, '=') + 1;
+        char name[128];
+        snprintf(name, sizeof(name), "%.*s", (int)(value - 1 - entry), entry);
+        self->sourceName = name;
+        self->sourceLine = 0;
+        Argparser_parseSetting(self, option, value);
+    }
+    self->sourceName = NULL;
+}
+
+// Checks the value of a numeric option, including all items of lists
+static bool Argparser_inRange(const ArgparserOption* option, const void* value, double min, double max)
+{
+    const void* items = value;
+    int count = 1;
+    if (option->type == ARGPARSER_TYPE_INTEGER_LIST || option->type == ARGPARSER_TYPE_FLOAT_LIST) {
+        items = ((const ArgparserList*)value)->items;
+        count = ((const ArgparserList*)value)->count;
+    }
+    for (int i = 0; i < count; i++) {
+        double number;
+        switch (option->type) {
+        case ARGPARSER_TYPE_INTEGER:
+        case ARGPARSER_TYPE_INTEGER_LIST:   number = ((const int*)items)[i]; break;
+        case ARGPARSER_TYPE_FLOAT:
+        case ARGPARSER_TYPE_FLOAT_LIST:     number = ((const float*)items)[i]; break;
+        case ARGPARSER_TYPE_INT64:          number = (double)*(const int64_t*)items; break;
+        case ARGPARSER_TYPE_UINT64:         number = (double)*(const uint64_t*)items; break;
+        case ARGPARSER_TYPE_DOUBLE:         number = *(const double*)items; break;
+        default:                            number = (double)*(const size_t*)items; break;
+        }
+        if (!(number >= min && number <= max))
+            return false;
+    }
+    return true;
+}
+
+// Checks the constraints after parsing, in one pass over their options
+static void Argparser_checkConstraints(Argparser* self)
+{
+    const ArgparserSchema* schema = self->schema;
+    char name[64];
+    char other[64];
+    self->argv = NULL;      // Violations have no position
+
+    for (size_t r = 0; r < schema->ruleCount; r++) {
+        const ArgparserRule* rule = &schema->rules[r];
+        const ArgparserOption* given = NULL;
+        for (uint32_t i = 0; i < rule->count; i++) {
+            uint32_t index = schema->ruleOptions[rule->first + i];
+            const ArgparserOption* option = &schema->options[index];
+            bool seen = Argparser_isSeen(self, index);
+
+            switch (rule->type) {
+            case ARGPARSER_CONSTRAINT_REQUIRED:
+                if (!seen)
+                    Argparser_fail(self, ARGPARSER_ERROR_CONSTRAINT, option, "option %s is required",
+                        Argparser_optionName(option, name, sizeof(name)));
+                break;
+
+            case ARGPARSER_CONSTRAINT_EXCLUSIVE:
+                if (seen && given)
+                    Argparser_fail(self, ARGPARSER_ERROR_CONSTRAINT, option, "options %s and %s cannot be combined",
+                        Argparser_optionName(given, name, sizeof(name)), Argparser_optionName(option, other, sizeof(other)));
+                if (seen)
+                    given = option;
+                break;
+
+            case ARGPARSER_CONSTRAINT_REQUIRES:
+                for (uint32_t j = 0; seen && j < rule->requiredCount; j++) {
+                    uint32_t required = schema->ruleOptions[rule->requiredFirst + j];
+                    if (!Argparser_isSeen(self, required))
+                        Argparser_fail(self, ARGPARSER_ERROR_CONSTRAINT, option, "option %s requires %s",
+                            Argparser_optionName(option, name, sizeof(name)),
+                            Argparser_optionName(&schema->options[required], other, sizeof(other)));
+                }
+                break;
+
+            case ARGPARSER_CONSTRAINT_RANGE: {
+                const void* value = Argparser_getValue(self, option);
+                if (seen && value && !Argparser_inRange(option, value, rule->min, rule->max)) {
+                    if (self->configLines && self->configLines[index]) {
+                        self->sourceName = self->configFile;
+                        self->sourceLine = self->configLines[index];
+                    }
+                    char reason[96];
+                    snprintf(reason, sizeof(reason), "must be between %g and %g", rule->min, rule->max);
+                    Argparser_exitDueToError(self, option, reason);
                 }
+                break;
+            }
+
+            default:
+                break;
             }
         }
     }
-
-    if (!foundOption)
-        Argparser_exitDueToUnknownOption(self);
 }
 
 int Argparser_parse(Argparser* self, int argc, const char **argv)
 {
     assert(self->valid);
+    if (self->parentSchema) {
+        // The previous parse failed within a command
+        self->schema = self->parentSchema;
+        self->parentSchema = NULL;
+    }
+    if (self->schema->completion && !self->error && argc > 1) {
+        if (strcmp(argv[1], "--__complete") == 0)
+            Argparser_complete(self, argc - 2, argv + 2);
+        if (strcmp(argv[1], "--__completion-script") == 0 && argc > 2)
+            exit(Argparser_writeCompletionScript(argv[0], argv[2], 1) ? 0 : 1);
+    }
+    ARGPARSER_STATS_START(start);
+    ARGPARSER_STATS_PREPARE(self, argc - 1);
+
+    Argparser_releaseFiles(self);
+    if (self->schema->responseFiles)
+        Argparser_expandResponseFiles(self, &argc, &argv);
 
     // Skip executable path
     self->argc = argc - 1;
     self->argv = argv + 1;
     self->out  = argv;
+    self->cpidx = 0;
+    self->indexBase = 0;
+    self->command = NULL;
+    self->copyValues = false;
+    const char* configFile = self->configFile;
+    if (self->schema->ruleCount || self->schema->environment || configFile)
+        Argparser_resetSeen(self);
 
-    for (; self->argc; self->argc--, self->argv++) {
-        const char *arg = self->argv[0];
-        if (arg[0] != '-' || !arg[1]) {
-            if (self->stopAtNonOption) {
-                break;       // Finished, exit loop
+    // With commands, the first non-option is the name of the command
+    bool commands = self->schema->commandCount > 0;
+    if (Argparser_parseOptions(self, self->schema->stopAtNonOption || commands) && commands)
+        Argparser_parseCommand(self);
+
+    if (self->positions) {
+        int first = (int)(self->argv - self->out);
+        for (int i = 0; i < self->argc && self->cpidx + i < self->positionCapacity; i++)
+            self->positions[self->cpidx + i] = first + i;
+    } else {
+        memmove(self->out + self->cpidx, self->argv,
+                self->argc * sizeof(*self->out));
+        self->out[self->cpidx + self->argc] = NULL;
+    }
+
+    int remaining = self->cpidx + self->argc;
+    if (self->schema->environment)
+        Argparser_applyEnvironment(self);
+    if (configFile)
+        Argparser_applyConfigFile(self, configFile);
+    if (self->schema->ruleCount)
+        Argparser_checkConstraints(self);
+    ARGPARSER_STATS_STOP(self, parseNs, start);
+    return remaining;
+}
+
+void Argparser_setPositionOutput(Argparser* self, int* positions, int capacity)
+{
+    assert(self->valid);
+    self->positions = positions;
+    self->positionCapacity = positions ? capacity : 0;
+}
+
+void Argparser_reset(Argparser* self)
+{
+    assert(self->valid);
+    if (self->parentSchema) {
+        self->schema = self->parentSchema;
+        self->parentSchema = NULL;
+    }
+    self->command = NULL;
+
+    for (int i = 0; i < self->listCount; i++)
+        memset(self->lists[i], 0, sizeof(ArgparserList));
+    self->listCount = 0;
+
+    // Keep the newest block, which is the largest
+    ArgparserArenaBlock* block = self->arena;
+    if (block) {
+        while (block->next) {
+            ArgparserArenaBlock* next = block->next->next;
+            ARGPARSER_FREE(block->next);
+            block->next = next;
+        }
+        block->used = 0;
+    }
+}
+
+const char** Argparser_getArguments(const Argparser* self)
+{
+    return self->out;
+}
+
+const ArgparserCommand* Argparser_getCommand(const Argparser* self)
+{
+    return self->command;
+}
+
+static void Argparser_resetError(ArgparserError* error)
+{
+    error->code = ARGPARSER_OK;
+    error->index = -1;
+    error->option = NULL;
+    if (error->message && error->messageSize)
+        error->message[0] = '\0';
+}
+
+int Argparser_tryParse(Argparser* self, int argc, const char **argv, ArgparserError* error)
+{
+    jmp_buf jump;
+    Argparser_resetError(error);
+    self->error = error;
+    self->errorJump = &jump;
+    if (setjmp(jump)) {
+        self->error = NULL;
+        self->errorJump = NULL;
+        return -1;
+    }
+
+    int remaining = Argparser_parse(self, argc, argv);
+    self->error = NULL;
+    self->errorJump = NULL;
+    return remaining;
+}
+
+static inline bool Argparser_isSpace(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+int Argparser_tokenize(const char* input, size_t length, char* arena, const char** argv, int maxArgs)
+{
+    const char* in = input;
+    const char* end = input + length;
+    char* out = arena;      // Never overtakes `in`, so tokenizing in place is safe
+    int count = 0;
+
+    for (;;) {
+        // Skip whitespace and line continuations between arguments
+        while (in < end && (Argparser_isSpace(*in) || (in[0] == '\\' && in + 1 < end && in[1] == '\n')))
+            in += Argparser_isSpace(*in) ? 1 : 2;
+        if (in == end)
+            break;
+
+        char* token = out;
+        while (in < end) {
+            char c = *in;
+            if (c > '\'' && c != '\\') {
+                // Fast path: regular characters
+                *out++ = c;
+                in++;
+            } else if (Argparser_isSpace(c)) {
+                in++;
+                break;
+            } else if (c == '\'') {
+                const char* close = (const char*)memchr(in + 1, '\'', end - in - 1);
+                if (!close)
+                    return -1;
+                memmove(out, in + 1, close - in - 1);
+                out += close - in - 1;
+                in = close + 1;
+            } else if (c == '"') {
+                for (in++;; in++) {
+                    if (in == end)
+                        return -1;
+                    c = *in;
+                    if (c == '"')
+                        break;
+                    if (c == '\\' && in + 1 < end
+                        && (in[1] == '"' || in[1] == '\\' || in[1] == '$' || in[1] == '`' || in[1] == '\n')) {
+                        c = *++in;
+                        if (c == '\n')
+                            continue;
+                    }
+                    *out++ = c;
+                }
+                in++;
+            } else if (c == '\\') {
+                if (in + 1 == end)
+                    return -1;
+                if (in[1] != '\n')
+                    *out++ = in[1];
+                in += 2;
+            } else {
+                *out++ = c;
+                in++;
             }
-            // If it's not option or a single char '-', copy verbatim
-            self->out[self->cpidx++] = self->argv[0];
+        }
+        *out++ = '\0';
+
+        if (count < maxArgs)
+            argv[count] = token;
+        count++;
+    }
+
+    if (count < maxArgs)
+        argv[count] = NULL;
+    return count;
+}
+
+typedef struct ArgparserStream
+{
+    int fd;
+    char *buffer;               // Has one spare byte to terminate a last, unterminated argument
+    size_t size;
+    size_t begin;               // Start of the first unprocessed argument
+    size_t end;                 // End of the data read so far
+    bool eof;
+} ArgparserStream;
+
+// Returns the position after the argument starting at `start`, or 0 if it is not read completely
+static size_t Argparser_findStreamArgument(ArgparserStream* stream, size_t start)
+{
+    const char* terminator = (const char*)memchr(stream->buffer + start, '\0', stream->end - start);
+    if (terminator)
+        return terminator - stream->buffer + 1;
+    if (stream->eof && start < stream->end) {
+        stream->buffer[stream->end++] = '\0';
+        return stream->end;
+    }
+    return 0;
+}
+
+// Moves unprocessed data to the front and reads more, returns false at the end of the input
+static bool Argparser_readStream(Argparser* self, ArgparserStream* stream)
+{
+    if (stream->eof)
+        return false;
+    if (stream->begin) {
+        memmove(stream->buffer, stream->buffer + stream->begin, stream->end - stream->begin);
+        stream->end -= stream->begin;
+        stream->begin = 0;
+    }
+    if (stream->end == stream->size)
+        Argparser_fail(self, ARGPARSER_ERROR_STREAM, NULL, "argument exceeds the chunk size of %zu bytes", stream->size);
+
+    for (;;) {
+#ifdef _WIN32
+        long count = _read(stream->fd, stream->buffer + stream->end, (unsigned)(stream->size - stream->end));
+#else
+        ssize_t count = read(stream->fd, stream->buffer + stream->end, stream->size - stream->end);
+#endif
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0)
+            Argparser_fail(self, ARGPARSER_ERROR_STREAM, NULL, "cannot read arguments: %s", strerror(errno));
+        stream->eof = count == 0;
+        stream->end += (size_t)count;
+        return true;
+    }
+}
+
+long Argparser_parseStream(Argparser* self, int fd, Argparser_argumentCallback* callback,
+    size_t chunkSize, ArgparserError* error)
+{
+    assert(self->valid);
+    ARGPARSER_STATS_START(start);
+    chunkSize = chunkSize ? chunkSize : 65536;
+    char* buffer = (char*)ARGPARSER_MALLOC(chunkSize + 1);     // Not modified after setjmp
+    ArgparserStream stream = { fd, buffer, chunkSize, 0, 0, false };
+
+    jmp_buf jump;
+    if (error) {
+        Argparser_resetError(error);
+        self->error = error;
+        self->errorJump = &jump;
+        if (setjmp(jump)) {
+            self->error = NULL;
+            self->errorJump = NULL;
+            self->copyValues = false;
+            ARGPARSER_FREE(buffer);
+            return -1;
+        }
+    }
+    // Allocation failures are reported like parse errors
+    Argparser_checkParseAllocation(self, buffer);
+    ARGPARSER_STATS_PREPARE(self, 0);
+    Argparser_prepareCopies(self);
+    if (self->schema->ruleCount)
+        Argparser_resetSeen(self);
+
+    const char* window[3];
+    long index = 0;
+    long arguments = 0;
+    bool optionsEnded = false;
+    for (;; index++) {
+        size_t first;
+        while (!(first = Argparser_findStreamArgument(&stream, stream.begin)) && Argparser_readStream(self, &stream));
+        if (!first)
+            break;
+
+        const char* arg = stream.buffer + stream.begin;
+        if (optionsEnded || arg[0] != '-' || !arg[1]) {
+            optionsEnded = optionsEnded || self->schema->stopAtNonOption;
+            callback(self, arg);
+            arguments++;
+            stream.begin = first;
+            continue;
+        }
+        if (strcmp(arg, "--") == 0) {
+            optionsEnded = true;
+            stream.begin = first;
             continue;
         }
 
-        // Check if it is a short option
-        if (arg[1] != '-') {
-            Argparser_parseShortOption(self, self->options);
+        // Single short options may use the following argument as value
+        size_t length = first - stream.begin;
+        size_t second = 0;
+        if (arg[1] != '-' && arg[2] == '\0') {
+            while (!(second = Argparser_findStreamArgument(&stream, stream.begin + length))
+                && Argparser_readStream(self, &stream));
+        }
+        window[0] = stream.buffer + stream.begin;
+        window[1] = second ? stream.buffer + stream.begin + length : NULL;
+        window[2] = NULL;
+
+        self->argv = window;
+        self->argc = second ? 2 : 1;
+        self->out = window;
+        self->indexBase = index;
+        if (window[0][1] != '-')
+            Argparser_parseShortOption(self);
+        else
+            Argparser_parseLongOption(self);
+
+        if (self->argv != window) {
+            stream.begin = second;      // The value was consumed
+            index++;
         } else {
-            // Check if it is a long option
-            if (arg[2]) {
-                Argparser_parseLongOption(self, self->options);
-            } else {
-                // It is --, stop argument parsing
-                self->argc--;
-                self->argv++;
-                break;       // Finished, exit loop
+            stream.begin += length;
+        }
+    }
+    self->copyValues = false;
+    if (self->schema->ruleCount)
+        Argparser_checkConstraints(self);
+
+    self->error = NULL;
+    self->errorJump = NULL;
+    ARGPARSER_FREE(buffer);
+#ifdef ARGPARSER_ENABLE_STATS
+    self->stats.arguments += index;
+#endif
+    ARGPARSER_STATS_STOP(self, parseNs, start);
+    return arguments;
+}
+
+#ifdef ARGPARSER_ENABLE_STATS
+const ArgparserStats* Argparser_getStats(const Argparser* self)
+{
+    assert(self->valid);
+    return &self->stats;
+}
+
+void Argparser_resetStats(Argparser* self)
+{
+    assert(self->valid);
+    ArgparserOptionStats* options = self->stats.options;
+    memset(&self->stats, 0, sizeof(self->stats));
+    if (options)
+        memset(options, 0, self->schema->optionCount * sizeof(*options));
+    self->stats.options = options;
+}
+
+static void Argparser_appendFormat(ArgparserBuffer* buffer, const char* format, ...)
+{
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    Argparser_append(buffer, text, length < (int)sizeof(text) ? (size_t)length : sizeof(text) - 1);
+}
+
+void Argparser_dumpStats(const Argparser* self, int fd, bool json)
+{
+    assert(self->valid);
+    const ArgparserStats* stats = &self->stats;
+    ArgparserBuffer buffer = { NULL, 0, 0 };
+    char name[64];
+
+    if (json) {
+        Argparser_appendFormat(&buffer, "{\"parses\":%llu,\"arguments\":%llu,\"parseNs\":%llu,\"lookupNs\":%llu,"
+            "\"conversionNs\":%llu,\"callbackNs\":%llu,\"options\":[",
+            (unsigned long long)stats->parses, (unsigned long long)stats->arguments,
+            (unsigned long long)stats->parseNs, (unsigned long long)stats->lookupNs,
+            (unsigned long long)stats->conversionNs, (unsigned long long)stats->callbackNs);
+    } else {
+        Argparser_appendFormat(&buffer, "%-24s %14llu\n%-24s %14llu\n", "parses",
+            (unsigned long long)stats->parses, "arguments", (unsigned long long)stats->arguments);
+        Argparser_appendFormat(&buffer, "%-24s %14llu\n%-24s %14llu\n%-24s %14llu\n%-24s %14llu\n",
+            "parse ns", (unsigned long long)stats->parseNs, "lookup ns", (unsigned long long)stats->lookupNs,
+            "conversion ns", (unsigned long long)stats->conversionNs, "callback ns", (unsigned long long)stats->callbackNs);
+        Argparser_appendFormat(&buffer, "\n%-24s %14s %14s\n", "option", "hits", "callback ns");
+    }
+
+    bool first = true;
+    for (size_t i = 0; i < self->schema->optionCount; i++) {
+        const ArgparserOption* option = &self->schema->options[i];
+        if (option->type == ARGPARSER_TYPE_GROUP)
+            continue;
+        if (option->longName)
+            snprintf(name, sizeof(name), "--%s", option->longName);
+        else
+            snprintf(name, sizeof(name), "-%c", option->shortName);
+        uint64_t hits = stats->options ? stats->options[i].hits : 0;
+        uint64_t callbackNs = stats->options ? stats->options[i].callbackNs : 0;
+
+        if (json) {
+            Argparser_appendString(&buffer, first ? "{\"name\":\"" : ",{\"name\":\"");
+            for (const char* c = name; *c; c++) {
+                if (*c == '"' || *c == '\\')
+                    Argparser_append(&buffer, "\\", 1);
+                Argparser_append(&buffer, c, 1);
+            }
+            Argparser_appendFormat(&buffer, "\",\"hits\":%llu,\"callbackNs\":%llu}",
+                (unsigned long long)hits, (unsigned long long)callbackNs);
+        } else {
+            Argparser_appendFormat(&buffer, "%-24s %14llu %14llu\n", name,
+                (unsigned long long)hits, (unsigned long long)callbackNs);
+        }
+        first = false;
+    }
+    if (json)
+        Argparser_appendString(&buffer, "]}\n");
+
+    Argparser_writeOut(fd, buffer.data, buffer.length);
+    ARGPARSER_FREE(buffer.data);
+}
+#endif
+
+#ifdef ARGPARSER_ENABLE_THREADS
+#define ARGPARSER_BATCH_CHUNK 64
+
+typedef struct ArgparserBatchRange
+{
+    size_t next;                // Claimed atomically by the owner and by thieves
+    size_t end;
+    char padding[64 - 2 * sizeof(size_t)];
+} ArgparserBatchRange;
+
+typedef struct ArgparserBatchWorker
+{
+    const ArgparserSchema* schema;
+    ArgparserBatchEntry* entries;
+    ArgparserBatchRange* ranges;
+    int count;
+    int id;
+    size_t failed;
+} ArgparserBatchWorker;
+
+static void Argparser_parseBatchEntry(Argparser* context, ArgparserBatchEntry* entry)
+{
+    if (context->schema->outputTemplate)
+        memcpy(entry->output, context->schema->outputTemplate, context->schema->outputSize);
+    Argparser_setOutput(context, entry->output);
+    entry->result = Argparser_tryParse(context, entry->argc, entry->argv, &entry->error);
+}
+
+static void* Argparser_runBatchWorker(void* data)
+{
+    ArgparserBatchWorker* worker = (ArgparserBatchWorker*)data;
+    Argparser context;
+    Argparser_initWithSchema(&context, worker->schema);
+
+    // Drain the own range first, then steal chunks from the other workers
+    for (int i = 0; i < worker->count; i++) {
+        ArgparserBatchRange* range = &worker->ranges[(worker->id + i) % worker->count];
+        for (;;) {
+            size_t begin = __atomic_fetch_add(&range->next, ARGPARSER_BATCH_CHUNK, __ATOMIC_RELAXED);
+            if (begin >= range->end)
+                break;
+            size_t end = begin + ARGPARSER_BATCH_CHUNK < range->end ? begin + ARGPARSER_BATCH_CHUNK : range->end;
+            for (size_t e = begin; e < end; e++) {
+                Argparser_parseBatchEntry(&context, &worker->entries[e]);
+                worker->failed += worker->entries[e].result < 0;
             }
         }
     }
+    Argparser_clear(&context);
+    return NULL;
+}
+
+size_t Argparser_parseBatch(const ArgparserSchema* schema, ArgparserBatchEntry* entries, size_t count, int threads)
+{
+    if (threads <= 0)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1)
+        threads = 1;
+    if ((size_t)threads > count / ARGPARSER_BATCH_CHUNK + 1)
+        threads = (int)(count / ARGPARSER_BATCH_CHUNK + 1);
+
+    ArgparserBatchRange* ranges = (ArgparserBatchRange*)Argparser_checkAllocation(
+        ARGPARSER_CALLOC(threads, sizeof(ArgparserBatchRange)));
+    ArgparserBatchWorker* workers = (ArgparserBatchWorker*)Argparser_checkAllocation(
+        ARGPARSER_CALLOC(threads, sizeof(ArgparserBatchWorker)));
+    pthread_t* handles = (pthread_t*)Argparser_checkAllocation(ARGPARSER_CALLOC(threads, sizeof(pthread_t)));
+    for (int i = 0; i < threads; i++) {
+        ranges[i].next = count * i / threads;
+        ranges[i].end = count * (i + 1) / threads;
+        workers[i].schema = schema;
+        workers[i].entries = entries;
+        workers[i].ranges = ranges;
+        workers[i].count = threads;
+        workers[i].id = i;
+    }
+
+    // The calling thread works as worker 0
+    int started = 1;
+    for (; started < threads; started++) {
+        if (pthread_create(&handles[started], NULL, Argparser_runBatchWorker, &workers[started]))
+            break;      // Continue with fewer threads, the others steal their ranges
+    }
+    Argparser_runBatchWorker(&workers[0]);
+
+    size_t failed = workers[0].failed;
+    for (int i = 1; i < started; i++) {
+        pthread_join(handles[i], NULL);
+        failed += workers[i].failed;
+    }
 
-    memmove(self->out + self->cpidx, self->argv,
-            self->argc * sizeof(*self->out));
-    self->out[self->cpidx + self->argc] = NULL;
+    ARGPARSER_FREE(handles);
+    ARGPARSER_FREE(workers);
+    ARGPARSER_FREE(ranges);
+    return failed;
+}
+#endif
 
-    return self->cpidx + self->argc;
+#ifdef __cplusplus
 }
+#endif
 
 #endif
@@ -0,0 +1,704 @@
+/**
+ * Argparser.hpp
+ *
+ * Copyright (C) 2018 Martin Weigel <mail@MartinWeigel.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include "Argparser.h"
+#include <cstddef>
+#include <cstdint>
+
+//******************************************************************************
+// C++17 front end: Compiles option tables into an `ArgparserSchema` at compile time.
+//
+//   static int number;
+//   static constexpr ArgparserOption options[] = {
+//       ARGPARSER_OPT_HELP(),
+//       ARGPARSER_OPT_INT('n', "number", &number, "an integer"),
+//       ARGPARSER_OPT_END()
+//   };
+//   static constexpr argparser::Settings settings = { "example [options]" };
+//   argparser::Parser parser(argparser::schema<options, settings>);
+//
+// The short index, the long index, and the help message are constants, so there is no startup cost.
+// Duplicate names and values of the wrong type are compile errors.
+// The implementation is still compiled from Argparser.h, either in a C or C++ translation unit.
+//******************************************************************************
+namespace argparser
+{
+
+/**
+ * Texts and flags of a schema, corresponding to the setters of the C API.
+ * The help message is rendered without wrapping, since the terminal width is unknown at compile time.
+ * Output templates are not available, as constant expressions cannot convert their pointers.
+ */
+struct Settings
+{
+    const char* usage = nullptr;
+    const char* description = nullptr;
+    const char* epilog = nullptr;
+    bool stopAtNonOption = false;
+    bool responseFiles = false;
+};
+
+inline constexpr Settings defaultSettings = {};
+
+
+
+//******************************************************************************
+// Typed option builders, used by the macros below
+//******************************************************************************
+constexpr ArgparserOption option(ArgparserOptionType type, char shortName, const char* longName,
+    void* value, const char* help, Argparser_callback* callback)
+{
+    return { type, shortName, longName, value, help, callback };
+}
+
+#define ARGPARSER_TYPED_BUILDER(name, type, valueType)                                      \
+    constexpr ArgparserOption name(char shortName, const char* longName, valueType* value,  \
+        const char* help, Argparser_callback* callback = nullptr)                           \
+    {                                                                                       \
+        return option(type, shortName, longName, value, help, callback);                    \
+    }
+
+ARGPARSER_TYPED_BUILDER(boolOption, ARGPARSER_TYPE_BOOLEAN, bool)
+ARGPARSER_TYPED_BUILDER(intOption, ARGPARSER_TYPE_INTEGER, int)
+ARGPARSER_TYPED_BUILDER(floatOption, ARGPARSER_TYPE_FLOAT, float)
+ARGPARSER_TYPED_BUILDER(stringOption, ARGPARSER_TYPE_STRING, const char*)
+ARGPARSER_TYPED_BUILDER(int64Option, ARGPARSER_TYPE_INT64, int64_t)
+ARGPARSER_TYPED_BUILDER(uint64Option, ARGPARSER_TYPE_UINT64, uint64_t)
+ARGPARSER_TYPED_BUILDER(doubleOption, ARGPARSER_TYPE_DOUBLE, double)
+ARGPARSER_TYPED_BUILDER(sizeOption, ARGPARSER_TYPE_SIZE, size_t)
+ARGPARSER_TYPED_BUILDER(stringListOption, ARGPARSER_TYPE_STRING_LIST, ArgparserList)
+ARGPARSER_TYPED_BUILDER(intListOption, ARGPARSER_TYPE_INTEGER_LIST, ArgparserList)
+ARGPARSER_TYPED_BUILDER(floatListOption, ARGPARSER_TYPE_FLOAT_LIST, ArgparserList)
+#undef ARGPARSER_TYPED_BUILDER
+
+constexpr ArgparserOption flagOption(char shortName, const char* longName, uint64_t* mask, unsigned bit,
+    const char* help, Argparser_callback* callback = nullptr)
+{
+    return { ARGPARSER_TYPE_FLAG, shortName, longName, mask, help, callback, bit };
+}
+
+/**
+ * The choices are hashed at compile time, so their array has to be constexpr and end with nullptr:
+ *
+ *     static constexpr const char* modes[] = { "fast", "slow", "auto", nullptr };
+ *     ARGPARSER_OPT_CHOICE('m', "mode", &mode, modes, "Processing mode")
+ *
+ * A mutable array fails the choice check of `schema` as "not usable in a constant expression".
+ */
+constexpr ArgparserOption choiceOption(char shortName, const char* longName, int* value,
+    const char* const* choices, const char* help, Argparser_callback* callback = nullptr)
+{
+    return { ARGPARSER_TYPE_CHOICE, shortName, longName, value, help, callback, 0, nullptr, choices };
+}
+
+/**
+ * Reads the option from the environment variable `name` when it is absent from the command line,
+ * e.g. `withEnv(ARGPARSER_OPT_INT('p', "port", &port, "Port"), "PORT")`.
+ */
+constexpr ArgparserOption withEnv(ArgparserOption option, const char* name)
+{
+    option.env = name;
+    return option;
+}
+
+constexpr ArgparserOption groupOption(const char* description)
+{
+    return option(ARGPARSER_TYPE_GROUP, 0, nullptr, nullptr, description, nullptr);
+}
+
+constexpr ArgparserOption endOption()
+{
+    return option(ARGPARSER_TYPE_END, 0, nullptr, nullptr, nullptr, nullptr);
+}
+
+
+
+//******************************************************************************
+// Compile-time helpers
+//******************************************************************************
+namespace detail
+{
+
+constexpr size_t length(const char* text)
+{
+    size_t length = 0;
+    while (text[length])
+        length++;
+    return length;
+}
+
+constexpr bool equal(const char* a, const char* b)
+{
+    for (; *a && *a == *b; a++, b++) {}
+    return *a == *b;
+}
+
+constexpr uint32_t hash(const char* name)
+{
+    uint32_t hash = ARGPARSER_HASH_INIT;
+    for (; *name; name++)
+        hash = ARGPARSER_HASH_STEP(hash, *name);
+    return hash;
+}
+
+constexpr bool hasLongName(const ArgparserOption& option)
+{
+    return option.longName && option.longName[0];
+}
+
+// Same placeholders as Argparser_valueHint
+constexpr const char* valueHint(const ArgparserOption& option)
+{
+    switch (option.type) {
+    case ARGPARSER_TYPE_INTEGER:    return "=<int>";
+    case ARGPARSER_TYPE_FLOAT:      return "=<float>";
+    case ARGPARSER_TYPE_STRING:     return "=<string>";
+    case ARGPARSER_TYPE_INT64:      return "=<int64>";
+    case ARGPARSER_TYPE_UINT64:     return "=<uint64>";
+    case ARGPARSER_TYPE_DOUBLE:     return "=<double>";
+    case ARGPARSER_TYPE_SIZE:       return "=<size>";
+    case ARGPARSER_TYPE_STRING_LIST:    return "=<string>...";
+    case ARGPARSER_TYPE_INTEGER_LIST:   return "=<int>...";
+    case ARGPARSER_TYPE_FLOAT_LIST:     return "=<float>...";
+    default:                        return "";
+    }
+}
+
+template <size_t N>
+struct Text;
+
+// Same placeholders as Argparser_appendValueHint
+template <size_t N>
+constexpr void appendValueHint(Text<N>& text, const ArgparserOption& option)
+{
+    if (option.type != ARGPARSER_TYPE_CHOICE) {
+        text.append(valueHint(option));
+        return;
+    }
+    for (const char* const* choice = option.choices; *choice; choice++) {
+        text.append(choice == option.choices ? "=<" : "|");
+        text.append(*choice);
+    }
+    text.append(">");
+}
+
+template <size_t N>
+constexpr size_t countOptions(const ArgparserOption (&options)[N])
+{
+    size_t count = 0;
+    while (count < N && options[count].type != ARGPARSER_TYPE_END)
+        count++;
+    return count;
+}
+
+template <size_t N>
+constexpr bool hasDuplicateShortNames(const ArgparserOption (&options)[N])
+{
+    bool seen[256] = {};
+    for (size_t i = 0, count = countOptions(options); i < count; i++) {
+        unsigned char name = (unsigned char)options[i].shortName;
+        if (name && seen[name])
+            return true;
+        seen[name] = true;
+    }
+    return false;
+}
+
+constexpr uint32_t reverseBits(uint32_t value)
+{
+    uint32_t reversed = 0;
+    for (int i = 0; i < 32; i++, value >>= 1)
+        reversed = (reversed << 1) | (value & 1);
+    return reversed;
+}
+
+// Hashes of the long names, each computed once. Sorted by their reversed bits, hashes that share
+// their low bits are neighbours, so duplicates and slot collisions are found in one pass.
+template <size_t Count>
+struct NameTable
+{
+    uint32_t hashes[Count ? Count : 1] = {};
+    uint32_t options[Count ? Count : 1] = {};     // Index of the option of each hash
+    size_t count = 0;
+};
+
+template <size_t Count>
+constexpr void siftDown(NameTable<Count>& names, size_t root, size_t end)
+{
+    for (size_t child = 2 * root + 1; child < end; root = child, child = 2 * root + 1) {
+        if (child + 1 < end && reverseBits(names.hashes[child + 1]) > reverseBits(names.hashes[child]))
+            child++;
+        if (reverseBits(names.hashes[root]) >= reverseBits(names.hashes[child]))
+            return;
+        uint32_t hash = names.hashes[root], option = names.options[root];
+        names.hashes[root] = names.hashes[child];
+        names.options[root] = names.options[child];
+        names.hashes[child] = hash;
+        names.options[child] = option;
+    }
+}
+
+template <size_t Count, size_t N>
+constexpr NameTable<Count> buildNameTable(const ArgparserOption (&options)[N])
+{
+    NameTable<Count> names = {};
+    for (size_t o = 0; o < Count; o++) {
+        if (hasLongName(options[o])) {
+            names.hashes[names.count] = hash(options[o].longName);
+            names.options[names.count++] = (uint32_t)o;
+        }
+    }
+    // Heapsort, the constant evaluation grows with n log n
+    for (size_t i = names.count / 2; i-- > 0; )
+        siftDown(names, i, names.count);
+    for (size_t end = names.count; end-- > 1; ) {
+        uint32_t hash = names.hashes[0], option = names.options[0];
+        names.hashes[0] = names.hashes[end];
+        names.options[0] = names.options[end];
+        names.hashes[end] = hash;
+        names.options[end] = option;
+        siftDown(names, 0, end);
+    }
+    return names;
+}
+
+// Equal names have equal hashes, which are neighbours in the table
+template <size_t Count, size_t N>
+constexpr bool hasDuplicateLongNames(const NameTable<Count>& names, const ArgparserOption (&options)[N])
+{
+    for (size_t i = 0; i < names.count; i++) {
+        for (size_t j = i + 1; j < names.count && names.hashes[j] == names.hashes[i]; j++) {
+            if (equal(options[names.options[i]].longName, options[names.options[j]].longName))
+                return true;
+        }
+    }
+    return false;
+}
+
+// Size of the long index like Argparser_init, grown until lookups need a single probe.
+// Neighbours in the table share the most low bits, so one pass finds the bits a perfect table needs.
+template <size_t Count>
+constexpr uint32_t longIndexSize(const NameTable<Count>& names)
+{
+    uint32_t size = 8;
+    while (size < 2 * names.count)
+        size <<= 1;
+
+    int shared = 0;     // Low bits shared by two hashes at most
+    for (size_t i = 1; i < names.count; i++) {
+        uint32_t difference = names.hashes[i] ^ names.hashes[i - 1];
+        int bits = 0;
+        while (bits < 32 && !((difference >> bits) & 1))
+            bits++;
+        shared = bits > shared ? bits : shared;
+    }
+    if (shared < 31) {
+        uint32_t perfect = 2u << shared;    // Smallest size with a home slot per name
+        if (perfect <= 64 * size)
+            return perfect > size ? perfect : size;
+    }
+    return size;    // Linear probing resolves the remaining collisions
+}
+
+constexpr uint32_t countChoices(const ArgparserOption& option)
+{
+    uint32_t count = 0;
+    while (option.choices && option.choices[count])
+        count++;
+    return count;
+}
+
+constexpr bool isPerfectChoice(const ArgparserOption& option, const ArgparserChoiceTable& table)
+{
+    for (uint32_t i = 0, count = countChoices(option); i < count; i++) {
+        for (uint32_t j = 0; j < i; j++) {
+            if (ARGPARSER_CHOICE_SLOT(hash(option.choices[i]), table.seed, table.bits)
+                == ARGPARSER_CHOICE_SLOT(hash(option.choices[j]), table.seed, table.bits))
+                return false;
+        }
+    }
+    return true;
+}
+
+// Seed and size like Argparser_buildChoices, more than 20 bits if the choices cannot be hashed
+constexpr ArgparserChoiceTable choiceTable(const ArgparserOption& option)
+{
+    ArgparserChoiceTable table = {};
+    table.bits = 1;
+    while ((1u << table.bits) < 2 * countChoices(option))
+        table.bits++;
+    for (; table.bits <= 20; table.bits++) {
+        for (table.seed = 0; table.seed < 64; table.seed++) {
+            if (isPerfectChoice(option, table))
+                return table;
+        }
+    }
+    return table;
+}
+
+template <size_t N>
+constexpr bool hasValidChoices(const ArgparserOption (&options)[N])
+{
+    for (size_t i = 0, count = countOptions(options); i < count; i++) {
+        if (options[i].type == ARGPARSER_TYPE_CHOICE
+            && (!countChoices(options[i]) || choiceTable(options[i]).bits > 20))
+            return false;
+    }
+    return true;
+}
+
+template <size_t N>
+constexpr size_t choiceSlotCount(const ArgparserOption (&options)[N])
+{
+    size_t slots = 0;
+    for (size_t i = 0, count = countOptions(options); i < count; i++) {
+        if (options[i].type == ARGPARSER_TYPE_CHOICE)
+            slots += (size_t)1 << choiceTable(options[i]).bits;
+    }
+    return slots;
+}
+
+template <size_t Count, size_t Slots>
+struct ChoiceIndex
+{
+    ArgparserChoiceTable tables[Count ? Count : 1];
+    uint32_t slots[Slots ? Slots : 1];
+};
+
+template <size_t Count, size_t Slots, size_t N>
+constexpr ChoiceIndex<Count, Slots> buildChoiceIndex(const ArgparserOption (&options)[N])
+{
+    ChoiceIndex<Count, Slots> index = {};
+    uint32_t used = 0;
+    for (size_t o = 0; o < Count; o++) {
+        if (options[o].type != ARGPARSER_TYPE_CHOICE)
+            continue;
+        ArgparserChoiceTable& table = index.tables[o];
+        table = choiceTable(options[o]);
+        table.first = used;
+        for (uint32_t c = 0; c < countChoices(options[o]); c++)
+            index.slots[used + ARGPARSER_CHOICE_SLOT(hash(options[o].choices[c]), table.seed, table.bits)] = c + 1;
+        used += 1u << table.bits;
+    }
+    return index;
+}
+
+template <uint32_t Size>
+struct LongIndex
+{
+    ArgparserIndexSlot slots[Size];
+};
+
+template <uint32_t Size, size_t Count>
+constexpr LongIndex<Size> buildLongIndex(const NameTable<Count>& names)
+{
+    LongIndex<Size> index = {};
+    for (size_t n = 0; n < names.count; n++) {
+        uint32_t i = names.hashes[n] & (Size - 1);
+        while (index.slots[i].option)
+            i = (i + 1) & (Size - 1);
+        index.slots[i].hash = names.hashes[n];
+        index.slots[i].option = names.options[n] + 1;
+    }
+    return index;
+}
+
+// Output of renderHelp: Counts the characters when N is 0
+template <size_t N>
+struct Text
+{
+    char data[N ? N : 1] = {};
+    size_t length = 0;
+
+    constexpr void append(const char* text, size_t count)
+    {
+        for (size_t i = 0; i < count; i++, length++) {
+            if (N)
+                data[length] = text[i];
+        }
+    }
+    constexpr void append(const char* text) { append(text, detail::length(text)); }
+    constexpr void appendSpaces(size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            append(" ", 1);
+    }
+};
+
+// Same layout as Argparser_renderHelp
+template <size_t Size, size_t N>
+constexpr Text<Size> renderHelp(const ArgparserOption (&options)[N], const Settings& settings)
+{
+    Text<Size> text = {};
+    if (settings.usage) {
+        text.append("Usage: ");
+        text.append(settings.usage);
+        text.append("\n");
+    }
+    if (settings.description) {
+        text.append(settings.description);
+        text.append("\n");
+    }
+
+    size_t count = countOptions(options);
+    size_t usage_opts_width = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t len = 0;
+        if (options[i].shortName)
+            len += 2;
+        if (options[i].shortName && options[i].longName)
+            len += 2;
+        if (options[i].longName)
+            len += length(options[i].longName) + 2;
+        Text<0> hint = {};
+        appendValueHint(hint, options[i]);
+        len += hint.length < ARGPARSER_HINT_WIDTH ? hint.length : ARGPARSER_HINT_WIDTH;
+        len = (len + 3) - ((len + 3) & 3);
+        if (usage_opts_width < len)
+            usage_opts_width = len;
+    }
+    usage_opts_width += 4;
+
+    for (size_t i = 0; i < count; i++) {
+        const ArgparserOption& option = options[i];
+        if (option.type == ARGPARSER_TYPE_GROUP) {
+            text.append("\n");
+            text.append(option.help);
+            text.append("\n");
+            continue;
+        }
+        size_t lineStart = text.length;
+        text.append("    ");
+        if (option.shortName) {
+            const char name[2] = { '-', option.shortName };
+            text.append(name, 2);
+        }
+        if (option.longName && option.shortName)
+            text.append(", ");
+        if (option.longName) {
+            text.append("--");
+            text.append(option.longName);
+        }
+        appendValueHint(text, option);
+
+        size_t pos = text.length - lineStart;
+        if (pos <= usage_opts_width) {
+            text.appendSpaces(usage_opts_width - pos + 2);
+        } else {
+            text.append("\n");
+            text.appendSpaces(usage_opts_width + 2);
+        }
+        text.append(option.help);
+        text.append("\n");
+    }
+
+    if (settings.epilog) {
+        text.append("\n");
+        text.append(settings.epilog);
+        text.append("\n");
+    }
+    return text;
+}
+
+template <const auto& Options>
+inline constexpr auto names = buildNameTable<countOptions(Options)>(Options);
+
+template <const auto& Options>
+inline constexpr auto longIndex = buildLongIndex<longIndexSize(names<Options>)>(names<Options>);
+
+template <const auto& Options>
+inline constexpr auto choiceIndex = buildChoiceIndex<countOptions(Options), choiceSlotCount(Options)>(Options);
+
+template <const auto& Options, const Settings& S>
+inline constexpr auto help = renderHelp<renderHelp<0>(Options, S).length + 1>(Options, S);
+
+template <const auto& Options, const Settings& S>
+constexpr ArgparserSchema buildSchema()
+{
+    static_assert(Options[sizeof(Options) / sizeof(Options[0]) - 1].type == ARGPARSER_TYPE_END,
+        "options have to end with ARGPARSER_OPT_END()");
+    static_assert(!hasDuplicateShortNames(Options), "a short option name is defined more than once");
+    static_assert(!hasDuplicateLongNames(names<Options>, Options), "a long option name is defined more than once");
+    // A non-constant condition here means that the choices of an option are not a constexpr array
+    static_assert(hasValidChoices(Options), "a choice option has no choices, duplicated ones, or a mutable array");
+
+    ArgparserSchema schema = {};
+    schema.options = Options;
+    schema.usage = S.usage;
+    schema.description = S.description;
+    schema.epilog = S.epilog;
+    schema.stopAtNonOption = S.stopAtNonOption;
+    schema.responseFiles = S.responseFiles;
+    constexpr size_t count = countOptions(Options);
+    schema.optionCount = count;
+    // The C structure is not const-qualified, but the parser only reads shared schemas
+    schema.longIndex = const_cast<ArgparserIndexSlot*>(longIndex<Options>.slots);
+    schema.longIndexMask = longIndexSize(names<Options>) - 1;
+    for (size_t i = 0; i < count; i++) {
+        if (Options[i].shortName)
+            schema.shortIndex[(unsigned char)Options[i].shortName] = &Options[i];
+        if (Options[i].env)
+            schema.environment = true;
+    }
+    if constexpr (choiceSlotCount(Options) > 0) {
+        schema.choiceTables = const_cast<ArgparserChoiceTable*>(choiceIndex<Options>.tables);
+        schema.choiceSlots = const_cast<uint32_t*>(choiceIndex<Options>.slots);
+    }
+    schema.help = const_cast<char*>(help<Options, S>.data);
+    schema.helpLength = help<Options, S>.length;
+    return schema;
+}
+
+} // namespace detail
+
+/**
+ * Compiled schema of a static option array, usable with `Argparser_initWithSchema()` or `Parser`.
+ */
+template <const auto& Options, const Settings& S = defaultSettings>
+inline constexpr ArgparserSchema schema = detail::buildSchema<Options, S>();
+
+
+
+//******************************************************************************
+// Parse context
+//******************************************************************************
+/**
+ * Owns an Argparser context for a shared schema and releases it on destruction.
+ * Use `get()` for the remaining functions of the C API.
+ */
+class Parser
+{
+public:
+    explicit Parser(const ArgparserSchema& schema) { Argparser_initWithSchema(&context, &schema); }
+    ~Parser() { Argparser_clear(&context); }
+    Parser(const Parser&) = delete;
+    Parser& operator=(const Parser&) = delete;
+
+    int parse(int argc, const char** argv) { return Argparser_parse(&context, argc, argv); }
+    // Errors return with longjmp, also when a callback reports them with Argparser_exitDueToError().
+    // The jump skips the destructors of the callback's locals, so callbacks must not rely on them.
+    int tryParse(int argc, const char** argv, ArgparserError& error)
+    {
+        return Argparser_tryParse(&context, argc, argv, &error);
+    }
+    const char** arguments() const { return Argparser_getArguments(&context); }
+    void setPositionOutput(int* positions, int capacity) { Argparser_setPositionOutput(&context, positions, capacity); }
+    void reset() { Argparser_reset(&context); }
+    void setOutput(void* output) { Argparser_setOutput(&context, output); }
+    Argparser* get() { return &context; }
+
+private:
+    Argparser context;
+};
+
+} // namespace argparser
+
+
+
+//******************************************************************************
+// The option macros of Argparser.h, redirected to the typed builders
+//******************************************************************************
+#undef ARGPARSER_OPT_BOOL
+#undef ARGPARSER_OPT_BOOL_CALLBACK
+#undef ARGPARSER_OPT_FLAG
+#undef ARGPARSER_OPT_FLAG_CALLBACK
+#undef ARGPARSER_OPT_INT
+#undef ARGPARSER_OPT_INT_CALLBACK
+#undef ARGPARSER_OPT_FLOAT
+#undef ARGPARSER_OPT_FLOAT_CALLBACK
+#undef ARGPARSER_OPT_INT64
+#undef ARGPARSER_OPT_INT64_CALLBACK
+#undef ARGPARSER_OPT_UINT64
+#undef ARGPARSER_OPT_UINT64_CALLBACK
+#undef ARGPARSER_OPT_DOUBLE
+#undef ARGPARSER_OPT_DOUBLE_CALLBACK
+#undef ARGPARSER_OPT_SIZE
+#undef ARGPARSER_OPT_SIZE_CALLBACK
+#undef ARGPARSER_OPT_STRING
+#undef ARGPARSER_OPT_STRING_CALLBACK
+#undef ARGPARSER_OPT_CHOICE
+#undef ARGPARSER_OPT_CHOICE_CALLBACK
+#undef ARGPARSER_OPT_STRING_LIST
+#undef ARGPARSER_OPT_STRING_LIST_CALLBACK
+#undef ARGPARSER_OPT_INT_LIST
+#undef ARGPARSER_OPT_INT_LIST_CALLBACK
+#undef ARGPARSER_OPT_FLOAT_LIST
+#undef ARGPARSER_OPT_FLOAT_LIST_CALLBACK
+#undef ARGPARSER_OPT_GROUP
+#undef ARGPARSER_OPT_END
+
+#define ARGPARSER_OPT_BOOL(shortName, longName, valuePtr, description) \
+    argparser::boolOption(shortName, longName, valuePtr, description)
+#define ARGPARSER_OPT_BOOL_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    argparser::boolOption(shortName, longName, valuePtr, description, callback)
+#define ARGPARSER_OPT_FLAG(shortName, longName, maskPtr, bit, description) \
+    argparser::flagOption(shortName, longName, maskPtr, bit, description)
+#define ARGPARSER_OPT_FLAG_CALLBACK(shortName, longName, maskPtr, bit, description, callback) \
+    argparser::flagOption(shortName, longName, maskPtr, bit, description, callback)
+#define ARGPARSER_OPT_INT(shortName, longName, valuePtr, description) \
+    argparser::intOption(shortName, longName, valuePtr, description)
+#define ARGPARSER_OPT_INT_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    argparser::intOption(shortName, longName, valuePtr, description, callback)
+#define ARGPARSER_OPT_FLOAT(shortName, longName, valuePtr, description) \
+    argparser::floatOption(shortName, longName, valuePtr, description)
+#define ARGPARSER_OPT_FLOAT_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    argparser::floatOption(shortName, longName, valuePtr, description, callback)
+#define ARGPARSER_OPT_INT64(shortName, longName, valuePtr, description) \
+    argparser::int64Option(shortName, longName, valuePtr, description)
+#define ARGPARSER_OPT_INT64_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    argparser::int64Option(shortName, longName, valuePtr, description, callback)
+#define ARGPARSER_OPT_UINT64(shortName, longName, valuePtr, description) \
+    argparser::uint64Option(shortName, longName, valuePtr, description)
+#define ARGPARSER_OPT_UINT64_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    argparser::uint64Option(shortName, longName, valuePtr, description, callback)
+#define ARGPARSER_OPT_DOUBLE(shortName, longName, valuePtr, description) \
+    argparser::doubleOption(shortName, longName, valuePtr, description)
+#define ARGPARSER_OPT_DOUBLE_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    argparser::doubleOption(shortName, longName, valuePtr, description, callback)
+#define ARGPARSER_OPT_SIZE(shortName, longName, valuePtr, description) \
+    argparser::sizeOption(shortName, longName, valuePtr, description)
+#define ARGPARSER_OPT_SIZE_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    argparser::sizeOption(shortName, longName, valuePtr, description, callback)
+#define ARGPARSER_OPT_STRING(shortName, longName, valuePtr, description) \
+    argparser::stringOption(shortName, longName, valuePtr, description)
+#define ARGPARSER_OPT_STRING_CALLBACK(shortName, longName, valuePtr, description, callback) \
+    argparser::stringOption(shortName, longName, valuePtr, description, callback)
+#define ARGPARSER_OPT_CHOICE(shortName, longName, valuePtr, choices, description) \
+    argparser::choiceOption(shortName, longName, valuePtr, choices, description)
+#define ARGPARSER_OPT_CHOICE_CALLBACK(shortName, longName, valuePtr, choices, description, callback) \
+    argparser::choiceOption(shortName, longName, valuePtr, choices, description, callback)
+#define ARGPARSER_OPT_STRING_LIST(shortName, longName, listPtr, description) \
+    argparser::stringListOption(shortName, longName, listPtr, description)
+#define ARGPARSER_OPT_STRING_LIST_CALLBACK(shortName, longName, listPtr, description, callback) \
+    argparser::stringListOption(shortName, longName, listPtr, description, callback)
+#define ARGPARSER_OPT_INT_LIST(shortName, longName, listPtr, description) \
+    argparser::intListOption(shortName, longName, listPtr, description)
+#define ARGPARSER_OPT_INT_LIST_CALLBACK(shortName, longName, listPtr, description, callback) \
+    argparser::intListOption(shortName, longName, listPtr, description, callback)
+#define ARGPARSER_OPT_FLOAT_LIST(shortName, longName, listPtr, description) \
+    argparser::floatListOption(shortName, longName, listPtr, description)
+#define ARGPARSER_OPT_FLOAT_LIST_CALLBACK(shortName, longName, listPtr, description, callback) \
+    argparser::floatListOption(shortName, longName, listPtr, description, callback)
+#define ARGPARSER_OPT_GROUP(description)     argparser::groupOption(description)
+#define ARGPARSER_OPT_END()                  argparser::endOption()
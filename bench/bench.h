@@ -0,0 +1,55 @@
+/**
+ * bench.h
+ *
+ * Small helpers shared by the Argparser benchmarks.
+ */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+static inline uint64_t bench_nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// xorshift64*, deterministic across runs
+static inline uint64_t bench_random(uint64_t* state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ull;
+}
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+// Counts the allocations of Argparser, define before including bench.h and the implementation
+#include <stdlib.h>
+
+static size_t bench_allocations;
+
+static void* bench_countMalloc(size_t size)
+{
+    bench_allocations++;
+    return malloc(size);
+}
+
+static void* bench_countCalloc(size_t count, size_t size)
+{
+    bench_allocations++;
+    return calloc(count, size);
+}
+
+static void* bench_countRealloc(void* pointer, size_t size)
+{
+    bench_allocations++;
+    return realloc(pointer, size);
+}
+
+#define ARGPARSER_MALLOC(size)              bench_countMalloc(size)
+#define ARGPARSER_CALLOC(count, size)       bench_countCalloc(count, size)
+#define ARGPARSER_REALLOC(pointer, size)    bench_countRealloc(pointer, size)
+#define ARGPARSER_FREE(pointer)             free(pointer)
+#endif
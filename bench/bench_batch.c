@@ -0,0 +1,91 @@
+/**
+ * Measures the throughput of `Argparser_parseBatch` for 1 to N threads.
+ */
+#define _POSIX_C_SOURCE 200809L
+#define ARGPARSER_ENABLE_THREADS
+#define ARGPARSER_IMPLEMENTATION
+#include "../Argparser.h"
+#include "bench.h"
+
+#define ENTRIES 200000
+#define ARGS_PER_ENTRY 12
+
+typedef struct Job
+{
+    bool verbose;
+    bool dryRun;
+    int priority;
+    int retries;
+    float timeout;
+    const char* queue;
+    const char* user;
+} Job;
+
+static Job defaults = { false, false, 0, 3, 30.f, "default", NULL };
+
+// 1, 2, 4, ... and finally the amount of processors
+static int nextThreadCount(int threads, long processors)
+{
+    if (threads < processors && threads * 2 > processors)
+        return (int)processors;
+    return threads * 2;
+}
+
+int main()
+{
+    Argparser* argparser = Argparser_new();
+    Argparser_init(argparser, (ArgparserOption[]) {
+        ARGPARSER_OPT_BOOL('v', "verbose", &defaults.verbose, "verbose output"),
+        ARGPARSER_OPT_BOOL('d', "dry-run", &defaults.dryRun, "do not run the job"),
+        ARGPARSER_OPT_INT('p', "priority", &defaults.priority, "job priority"),
+        ARGPARSER_OPT_INT('r', "retries", &defaults.retries, "retries on failure"),
+        ARGPARSER_OPT_FLOAT('t', "timeout", &defaults.timeout, "timeout in seconds"),
+        ARGPARSER_OPT_STRING('q', "queue", &defaults.queue, "target queue"),
+        ARGPARSER_OPT_STRING('u', "user", &defaults.user, "submitting user"),
+        ARGPARSER_OPT_END()
+    });
+    Argparser_setOutputTemplate(argparser, &defaults, sizeof(defaults));
+    const ArgparserSchema* schema = Argparser_getSchema(argparser);
+
+    static const char* stored[ARGS_PER_ENTRY] = {
+        "job", "-v", "--priority=5", "-r", "7", "--timeout=2.5", "-d",
+        "-q", "batch", "--user=alice", "input.dat", "output.dat"
+    };
+    ArgparserBatchEntry* entries = calloc(ENTRIES, sizeof(ArgparserBatchEntry));
+    const char** argvs = malloc(ENTRIES * (ARGS_PER_ENTRY + 1) * sizeof(*argvs));
+    Job* jobs = malloc(ENTRIES * sizeof(Job));
+    for (int i = 0; i < ENTRIES; i++) {
+        entries[i].argv = argvs + i * (ARGS_PER_ENTRY + 1);
+        entries[i].output = &jobs[i];
+    }
+
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    double single = 0;
+    printf("%8s %14s %10s\n", "threads", "entries/s", "speedup");
+    for (int threads = 1; threads <= processors; threads = nextThreadCount(threads, processors)) {
+        // Parsing compacts argv, so restore the stored vectors before each run
+        for (int i = 0; i < ENTRIES; i++) {
+            memcpy(entries[i].argv, stored, sizeof(stored));
+            entries[i].argv[ARGS_PER_ENTRY] = NULL;
+            entries[i].argc = ARGS_PER_ENTRY;
+        }
+
+        uint64_t start = bench_nowNs();
+        size_t failed = Argparser_parseBatch(schema, entries, ENTRIES, threads);
+        uint64_t elapsed = bench_nowNs() - start;
+
+        double rate = ENTRIES / (elapsed / 1e9);
+        if (threads == 1)
+            single = rate;
+        if (failed || jobs[ENTRIES - 1].retries != 7)
+            fprintf(stderr, "unexpected batch result\n");
+        printf("%8d %14.0f %9.2fx\n", threads, rate, rate / single);
+    }
+
+    free(jobs);
+    free(argvs);
+    free(entries);
+    Argparser_clear(argparser);
+    Argparser_delete(argparser);
+    return 0;
+}
@@ -0,0 +1,78 @@
+/**
+ * Measures applying a large config file with `Argparser_setConfigFile`,
+ * with and without sections, and counts the allocations per parse.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#define BENCH_COUNT_ALLOCATIONS
+#include "bench.h"
+
+#define ARGPARSER_IMPLEMENTATION
+#include "../Argparser.h"
+
+#define LINES       10000
+#define SECTION     100         // Options per section
+#define RUNS        20
+#define PATH        "/tmp/argparser_bench_config.ini"
+
+static char names[LINES][24];
+static int integers[LINES];
+static const char* strings[LINES];
+static ArgparserOption options[LINES + 1];
+
+static void writeConfig(bool sections)
+{
+    FILE* file = fopen(PATH, "w");
+    for (int i = 0; i < LINES; i++) {
+        if (sections && i % SECTION == 0)
+            fprintf(file, "\n# Settings of group %d\n[group%d]\n", i / SECTION, i / SECTION);
+        const char* key = sections ? strchr(names[i], '-') + 1 : names[i];
+        if (i % 2)
+            fprintf(file, "%s = \"value %d\"\n", key, i);
+        else
+            fprintf(file, "%s = %d\n", key, i);
+    }
+    fclose(file);
+}
+
+static void run(const char* name, bool sections)
+{
+    writeConfig(sections);
+    Argparser* argparser = Argparser_new();
+    Argparser_init(argparser, options);
+    Argparser_setConfigFile(argparser, PATH);
+
+    const char* argv[] = { "bench", "--group0-option0=1", NULL };
+    Argparser_parse(argparser, 2, argv);    // Allocates the reusable buffers
+    uint64_t best = UINT64_MAX;
+    bench_allocations = 0;
+    for (int r = 0; r < RUNS; r++) {
+        uint64_t start = bench_nowNs();
+        Argparser_parse(argparser, 2, argv);
+        uint64_t elapsed = bench_nowNs() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    if (integers[0] != 1 || integers[LINES - 2] != LINES - 2)
+        fprintf(stderr, "unexpected values\n");
+
+    printf("%-12s %10.1f us %8.1f ns/line %8.1f allocs/parse\n",
+        name, best / 1e3, (double)best / LINES, (double)bench_allocations / RUNS);
+    Argparser_delete(argparser);
+}
+
+int main()
+{
+    for (int i = 0; i < LINES; i++) {
+        snprintf(names[i], sizeof(names[i]), "group%d-option%d", i / SECTION, i % SECTION);
+        ArgparserOption option = i % 2
+            ? (ArgparserOption)ARGPARSER_OPT_STRING(0, names[i], &strings[i], "string")
+            : (ArgparserOption)ARGPARSER_OPT_INT(0, names[i], &integers[i], "integer");
+        memcpy(&options[i], &option, sizeof(option));
+    }
+
+    printf("config file with %d lines\n", LINES);
+    run("flat keys", false);
+    run("sections", true);
+    remove(PATH);
+    return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * Measures reading options from the environment with `Argparser_setEnvPrefix`,
+ * next to one `getenv` call per option, for growing environments.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include "bench.h"
+#define ARGPARSER_IMPLEMENTATION
+#include "../Argparser.h"
+
+#define OPTIONS     500
+#define RUNS        200
+
+static char names[OPTIONS][24];
+static int integers[OPTIONS];
+static ArgparserOption options[OPTIONS + 1];
+
+// Sets `count` unrelated variables and one variable for every fourth option
+static void fillEnvironment(int count)
+{
+    char name[32], value[16];
+    for (int i = 0; i < count; i++) {
+        snprintf(name, sizeof(name), "UNRELATED_VARIABLE_%d", i);
+        setenv(name, "value", 1);
+    }
+    for (int i = 0; i < OPTIONS; i += 4) {
+        snprintf(name, sizeof(name), "BENCH_OPTION_%d", i);
+        snprintf(value, sizeof(value), "%d", i);
+        setenv(name, value, 1);
+    }
+}
+
+static void run(int count)
+{
+    fillEnvironment(count);
+    Argparser* argparser = Argparser_new();
+    Argparser_init(argparser, options);
+    Argparser_setEnvPrefix(argparser, "BENCH_");
+
+    const char* argv[] = { "bench", NULL };
+    Argparser_parse(argparser, 1, argv);    // Allocates the reusable buffers
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < RUNS; r++) {
+        uint64_t start = bench_nowNs();
+        Argparser_parse(argparser, 1, argv);
+        uint64_t elapsed = bench_nowNs() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    if (integers[OPTIONS - 4] != OPTIONS - 4)
+        fprintf(stderr, "unexpected values\n");
+
+    uint64_t bestGetenv = UINT64_MAX;
+    char name[32];
+    for (int r = 0; r < RUNS; r++) {
+        uint64_t start = bench_nowNs();
+        for (int i = 0; i < OPTIONS; i++) {
+            snprintf(name, sizeof(name), "BENCH_OPTION_%d", i);
+            const char* value = getenv(name);
+            if (value)
+                integers[i] = atoi(value);
+        }
+        uint64_t elapsed = bench_nowNs() - start;
+        bestGetenv = elapsed < bestGetenv ? elapsed : bestGetenv;
+    }
+
+    printf("%8d %12.1f %12.1f %8.2fx\n", count, best / 1e3, bestGetenv / 1e3, (double)bestGetenv / best);
+    Argparser_delete(argparser);
+}
+
+int main()
+{
+    for (int i = 0; i < OPTIONS; i++) {
+        snprintf(names[i], sizeof(names[i]), "option-%d", i);
+        ArgparserOption option = ARGPARSER_OPT_INT(0, names[i], &integers[i], "integer");
+        memcpy(&options[i], &option, sizeof(option));
+    }
+
+    printf("%d options, every fourth set in the environment\n", OPTIONS);
+    printf("%8s %12s %12s %9s\n", "env vars", "argparser us", "getenv us", "speedup");
+    run(0);
+    run(100);
+    run(1000);
+    return 0;
+}
@@ -0,0 +1,70 @@
+/**
+ * Compares the parser generated by tools/argparser_gen.c from bench_generated.spec
+ * against the generic `Argparser_parse` with the same options.
+ */
+#define _POSIX_C_SOURCE 200809L
+#define ARGPARSER_IMPLEMENTATION
+#include "../Argparser.h"
+#include "bench.h"
+#include "bench_generated.gen.h"
+
+#define PARSES 500000
+
+static const char* arguments[] = {
+    "bench", "-v", "--jobs=8", "input-1.dat", "--retries=3", "--ratio=0.75", "-t", "2.5",
+    "--output=result.txt", "--format=json", "--log-file=bench.log", "input-2.dat", "-f",
+    "--offset=-4096", "--buffer-size=64Ki", "--seed=12345", "--dry-run", "-rq", "--", "-last",
+};
+#define ARGUMENTS (int)(sizeof(arguments) / sizeof(*arguments))
+
+int main()
+{
+    BenchOptions values = {0};
+    Argparser* argparser = Argparser_new();
+    Argparser_init(argparser, (ArgparserOption[]) {
+        ARGPARSER_OPT_HELP(),
+        ARGPARSER_OPT_BOOL('v', "verbose", &values.verbose, "print more details"),
+        ARGPARSER_OPT_BOOL('q', "quiet", &values.quiet, "print less details"),
+        ARGPARSER_OPT_BOOL('f', "force", &values.force, "overwrite existing files"),
+        ARGPARSER_OPT_BOOL('r', "recursive", &values.recursive, "descend into directories"),
+        ARGPARSER_OPT_INT('j', "jobs", &values.jobs, "number of parallel jobs"),
+        ARGPARSER_OPT_INT(0, "retries", &values.retries, "number of retries"),
+        ARGPARSER_OPT_FLOAT(0, "ratio", &values.ratio, "compression ratio"),
+        ARGPARSER_OPT_DOUBLE('t', "timeout", &values.timeout, "timeout in seconds"),
+        ARGPARSER_OPT_STRING('o', "output", &values.output, "output file"),
+        ARGPARSER_OPT_STRING(0, "format", &values.format, "output format"),
+        ARGPARSER_OPT_STRING(0, "log-file", &values.logFile, "log file"),
+        ARGPARSER_OPT_INT64(0, "offset", &values.offset, "start offset"),
+        ARGPARSER_OPT_SIZE(0, "buffer-size", &values.bufferSize, "size of the buffers"),
+        ARGPARSER_OPT_UINT64(0, "seed", &values.seed, "random seed"),
+        ARGPARSER_OPT_BOOL(0, "dry-run", &values.dryRun, "only print the actions"),
+        ARGPARSER_OPT_END()
+    });
+
+    const char* argv[ARGUMENTS + 1];
+    int remaining = 0;
+    uint64_t start = bench_nowNs();
+    for (int i = 0; i < PARSES; i++) {
+        memcpy(argv, arguments, sizeof(arguments));     // Parsing reorders argv
+        remaining += Argparser_parse(argparser, ARGUMENTS, argv);
+    }
+    uint64_t generic = bench_nowNs() - start;
+    BenchOptions expected = values;
+
+    BenchOptions options = {0};
+    start = bench_nowNs();
+    for (int i = 0; i < PARSES; i++) {
+        memcpy(argv, arguments, sizeof(arguments));
+        remaining -= Bench_parse(&options, ARGUMENTS, argv, NULL);
+    }
+    uint64_t generated = bench_nowNs() - start;
+
+    printf("%-10s %12s %12s %9s\n", "ns/parse", "generic", "generated", "speedup");
+    printf("%-10d %12.1f %12.1f %8.2fx\n", ARGUMENTS - 1,
+        (double)generic / PARSES, (double)generated / PARSES, (double)generic / generated);
+    if (remaining != 0 || memcmp(&options, &expected, sizeof(options)) != 0)
+        fprintf(stderr, "results differ\n");
+
+    Argparser_delete(argparser);
+    return 0;
+}
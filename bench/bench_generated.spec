@@ -0,0 +1,20 @@
+# Options of bench_generated.c, compiled by tools/argparser_gen.c
+name    Bench
+usage   bench_generated [options] files...
+
+help    h   help            -           show this help message and exit
+bool    v   verbose         verbose     print more details
+bool    q   quiet           quiet       print less details
+bool    f   force           force       overwrite existing files
+bool    r   recursive       recursive   descend into directories
+int     j   jobs            jobs        number of parallel jobs
+int     -   retries         retries     number of retries
+float   -   ratio           ratio       compression ratio
+double  t   timeout         timeout     timeout in seconds
+string  o   output          output      output file
+string  -   format          format      output format
+string  -   log-file        logFile     log file
+int64   -   offset          offset      start offset
+size    -   buffer-size     bufferSize  size of the buffers
+uint64  -   seed            seed        random seed
+bool    -   dry-run         dryRun      only print the actions
@@ -0,0 +1,96 @@
+/**
+ * Compares the previous linear long option lookup against the hashed index
+ * built by `Argparser_init` for growing option tables, resolving the same arguments on both sides.
+ */
+#define _POSIX_C_SOURCE 200809L
+#define ARGPARSER_IMPLEMENTATION
+#include "../Argparser.h"
+#include "bench.h"
+
+#define ARGUMENTS 20000
+#define RUNS      5
+
+// Lookup as done before the index: strlen + strncmp against every option
+static const ArgparserOption* linearLookup(const ArgparserOption* options, const char* arg)
+{
+    const ArgparserOption* found = NULL;
+    for (; options->type != ARGPARSER_TYPE_END; options++) {
+        size_t nameLength = strlen(options->longName);
+        if (strncmp(arg + 2, options->longName, nameLength) == 0)
+            found = options;
+    }
+    return found;
+}
+
+// Lookup as done by Argparser_parseLongOption: hash up to `=` and probe the index
+static const ArgparserOption* indexLookup(const ArgparserSchema* schema, const char* arg)
+{
+    const char *name = arg + 2;
+    const char *rest = name;
+    uint32_t hash = ARGPARSER_HASH_INIT;
+    for (; *rest != '\0' && *rest != '='; rest++)
+        hash = ARGPARSER_HASH_STEP(hash, *rest);
+    return Argparser_findLongOption(schema, name, rest - name, hash);
+}
+
+int main()
+{
+    static const int optionCounts[] = { 10, 100, 1000, 10000 };
+    uint64_t seed = 42;
+
+    printf("%8s %14s %14s %8s\n", "options", "linear ns/arg", "index ns/arg", "speedup");
+    for (size_t c = 0; c < sizeof(optionCounts) / sizeof(*optionCounts); c++) {
+        int count = optionCounts[c];
+        ArgparserOption* options = calloc(count + 1, sizeof(ArgparserOption));
+        char (*names)[24] = malloc(count * sizeof(*names));
+        bool* values = calloc(count, sizeof(bool));
+        for (int i = 0; i < count; i++) {
+            snprintf(names[i], sizeof(*names), "option-%d", i);
+            ArgparserOption option = ARGPARSER_OPT_BOOL(0, names[i], &values[i], "benchmark option");
+            memcpy(&options[i], &option, sizeof(option));
+        }
+
+        char (*args)[32] = malloc((ARGUMENTS + 1) * sizeof(*args));
+        const char** argv = malloc((ARGUMENTS + 2) * sizeof(*argv));
+        argv[0] = "bench";
+        for (int i = 0; i < ARGUMENTS; i++) {
+            snprintf(args[i], sizeof(*args), "--option-%d", (int)(bench_random(&seed) % count));
+            argv[i + 1] = args[i];
+        }
+        argv[ARGUMENTS + 1] = NULL;
+
+        Argparser* argparser = Argparser_new();
+        Argparser_init(argparser, options);
+        const ArgparserSchema* schema = Argparser_getSchema(argparser);
+
+        // Both sides resolve the same arguments, the best of several runs is kept
+        uint64_t linear = UINT64_MAX, indexed = UINT64_MAX;
+        size_t hits = 0;
+        for (int r = 0; r < RUNS; r++) {
+            uint64_t start = bench_nowNs();
+            for (int i = 1; i <= ARGUMENTS; i++)
+                hits += linearLookup(options, argv[i]) != NULL;
+            uint64_t elapsed = bench_nowNs() - start;
+            linear = elapsed < linear ? elapsed : linear;
+
+            start = bench_nowNs();
+            for (int i = 1; i <= ARGUMENTS; i++)
+                hits += indexLookup(schema, argv[i]) != NULL;
+            elapsed = bench_nowNs() - start;
+            indexed = elapsed < indexed ? elapsed : indexed;
+        }
+        Argparser_delete(argparser);
+
+        if (hits != 2 * RUNS * ARGUMENTS)
+            fprintf(stderr, "unexpected lookup result\n");
+        printf("%8d %14.1f %14.1f %7.1fx\n", count,
+            (double)linear / ARGUMENTS, (double)indexed / ARGUMENTS, (double)linear / indexed);
+
+        free(argv);
+        free(args);
+        free(values);
+        free(names);
+        free(options);
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * Compares the number conversions of Argparser against strtol/strtoll and strtod.
+ */
+#define _POSIX_C_SOURCE 200809L
+#define ARGPARSER_IMPLEMENTATION
+#include "../Argparser.h"
+#include "bench.h"
+
+#define VALUES 1000000
+
+typedef struct Result
+{
+    uint64_t ns;
+    uint64_t checksum;      // Keeps the compiler from dropping conversions
+} Result;
+
+static void report(const char* name, Result libc, Result argparser)
+{
+    printf("%-10s %12.2f %12.2f %8.2fx\n", name,
+        (double)libc.ns / VALUES, (double)argparser.ns / VALUES, (double)libc.ns / argparser.ns);
+    if (libc.checksum != argparser.checksum)
+        fprintf(stderr, "%s: results differ\n", name);
+}
+
+int main()
+{
+    uint64_t seed = 1;
+    char (*integers)[24] = malloc(VALUES * sizeof(*integers));
+    char (*decimals)[32] = malloc(VALUES * sizeof(*decimals));
+    for (int i = 0; i < VALUES; i++) {
+        snprintf(integers[i], sizeof(*integers), "%lld", (long long)(bench_random(&seed) >> (bench_random(&seed) % 64)) / 2);
+        snprintf(decimals[i], sizeof(*decimals), "%.*f", (int)(bench_random(&seed) % 7),
+            (double)(bench_random(&seed) % 100000000) / 1000.0);
+    }
+
+    Result libc = { 0, 0 }, argparser = { 0, 0 };
+    uint64_t start = bench_nowNs();
+    for (int i = 0; i < VALUES; i++)
+        libc.checksum += (uint64_t)strtoll(integers[i], NULL, 0);
+    libc.ns = bench_nowNs() - start;
+    start = bench_nowNs();
+    for (int i = 0; i < VALUES; i++) {
+        int64_t value;
+        Argparser_toInt64(integers[i], &value);
+        argparser.checksum += (uint64_t)value;
+    }
+    argparser.ns = bench_nowNs() - start;
+
+    printf("%-10s %12s %12s %9s\n", "ns/value", "libc", "Argparser", "speedup");
+    report("int64", libc, argparser);
+
+    libc = (Result){ 0, 0 };
+    argparser = (Result){ 0, 0 };
+    start = bench_nowNs();
+    for (int i = 0; i < VALUES; i++) {
+        double value = strtod(decimals[i], NULL);
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        libc.checksum += bits;
+    }
+    libc.ns = bench_nowNs() - start;
+    start = bench_nowNs();
+    for (int i = 0; i < VALUES; i++) {
+        double value;
+        uint64_t bits;
+        Argparser_toDouble(decimals[i], &value);
+        memcpy(&bits, &value, sizeof(bits));
+        argparser.checksum += bits;
+    }
+    argparser.ns = bench_nowNs() - start;
+    report("double", libc, argparser);
+
+    free(decimals);
+    free(integers);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * Measures replaying recorded command lines: a fresh context and a copy of argv
+ * per line, next to one context with `Argparser_setPositionOutput` and `Argparser_reset`.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#define BENCH_COUNT_ALLOCATIONS
+#include "bench.h"
+
+#define ARGPARSER_IMPLEMENTATION
+#include "../Argparser.h"
+
+#define RECORDED    1000        // Distinct command lines
+#define REPLAYS     1000000
+#define MAX_ARGS    16
+
+static int number;
+static bool verbose;
+static const char* name;
+static ArgparserList includes;
+static ArgparserOption options[] = {
+    ARGPARSER_OPT_INT('n', "number", &number, "number"),
+    ARGPARSER_OPT_BOOL('v', "verbose", &verbose, "verbose"),
+    ARGPARSER_OPT_STRING(0, "name", &name, "name"),
+    ARGPARSER_OPT_STRING_LIST('I', "include", &includes, "include directory"),
+    ARGPARSER_OPT_END(),
+};
+
+static const char* lines[RECORDED][MAX_ARGS + 1];
+static int counts[RECORDED];
+static char storage[RECORDED * MAX_ARGS * 16];
+
+static void record()
+{
+    uint64_t seed = 42;
+    char* text = storage;
+    for (int l = 0; l < RECORDED; l++) {
+        int count = 1;
+        lines[l][0] = "replay";
+        while (count < MAX_ARGS - 1) {
+            const char* arg = text;
+            switch (bench_random(&seed) % 6) {
+            case 0:  text += sprintf(text, "--number=%d", (int)(bench_random(&seed) % 1000)) + 1; break;
+            case 1:  text += sprintf(text, "--verbose") + 1; break;
+            case 2:  text += sprintf(text, "--name=line%d", l) + 1; break;
+            case 3:  text += sprintf(text, "--include=src%d", (int)(bench_random(&seed) % 10)) + 1; break;
+            default: text += sprintf(text, "file%d.txt", count) + 1; break;
+            }
+            lines[l][count++] = arg;
+            if (bench_random(&seed) % 8 == 0)
+                break;
+        }
+        lines[l][count] = NULL;
+        counts[l] = count;
+    }
+}
+
+static void report(const char* label, uint64_t ns, long remaining)
+{
+    printf("%-20s %8.1f ns/line %8.2f allocs/line %10ld remaining\n",
+        label, (double)ns / REPLAYS, (double)bench_allocations / REPLAYS, remaining);
+}
+
+int main()
+{
+    record();
+    printf("replaying %d recorded command lines %d times\n", RECORDED, REPLAYS / RECORDED);
+
+    // Parsing reorders argv, so every line is copied and parsed by a fresh context
+    const char* argv[MAX_ARGS + 1];
+    long remaining = 0;
+    bench_allocations = 0;
+    uint64_t start = bench_nowNs();
+    for (int r = 0; r < REPLAYS; r++) {
+        int l = r % RECORDED;
+        memcpy(argv, lines[l], (counts[l] + 1) * sizeof(*argv));
+        Argparser argparser;
+        Argparser_init(&argparser, options);
+        remaining += Argparser_parse(&argparser, counts[l], argv);
+        Argparser_clear(&argparser);
+        includes = (ArgparserList){0};
+    }
+    report("init/parse/clear", bench_nowNs() - start, remaining);
+
+    // One context reads the recorded lines in place
+    int positions[MAX_ARGS];
+    Argparser argparser;
+    Argparser_init(&argparser, options);
+    Argparser_setPositionOutput(&argparser, positions, MAX_ARGS);
+    remaining = 0;
+    bench_allocations = 0;
+    start = bench_nowNs();
+    for (int r = 0; r < REPLAYS; r++) {
+        int l = r % RECORDED;
+        remaining += Argparser_parse(&argparser, counts[l], lines[l]);
+        Argparser_reset(&argparser);
+    }
+    report("positions/reset", bench_nowNs() - start, remaining);
+    Argparser_clear(&argparser);
+    return 0;
+}
@@ -0,0 +1,224 @@
+/**
+ * Measures `Argparser_parse` for growing option tables and argument vectors
+ * with different kinds of arguments, next to glibc's `getopt_long`.
+ * Each configuration runs in its own process to report its peak RSS.
+ */
+#define _GNU_SOURCE
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stdlib.h>
+#define BENCH_COUNT_ALLOCATIONS
+#include "bench.h"
+
+#define ARGPARSER_IMPLEMENTATION
+#include "../Argparser.h"
+
+#define MIN_ARGUMENTS       500000      // Repeat small vectors to get measurable times
+#define MAX_GETOPT_WORK     200000000   // getopt_long scans all long options per argument
+#define MAX_GETOPT_PERMUTED 100000      // and moves interleaved positional arguments one by one
+
+enum Mix { MIX_SHORT, MIX_COMPOUND, MIX_LONG, MIX_VALUE, MIX_POSITIONAL, MIX_MIXED, MIX_COUNT };
+static const char* mixNames[] = { "short", "compound", "long", "=value", "positional", "mixed" };
+
+typedef struct Table
+{
+    int count;
+    char (*names)[24];
+    bool* booleans;
+    int* integers;
+    ArgparserOption* options;
+    struct option* longOptions;
+    char shortOptions[128];
+    char shortNames[64];        // Short names of the boolean options
+    int shortCount;
+} Table;
+
+// Every fourth option is an integer, the first options also have short names
+static void buildTable(Table* table, int count)
+{
+    static const char letters[] = "abcdefgijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    table->count = count;
+    table->names = malloc(count * sizeof(*table->names));
+    table->booleans = calloc(count, sizeof(bool));
+    table->integers = calloc(count, sizeof(int));
+    table->options = calloc(count + 1, sizeof(ArgparserOption));
+    table->longOptions = calloc(count + 1, sizeof(struct option));
+    size_t s = 0;
+    table->shortCount = 0;
+    for (int i = 0; i < count; i++) {
+        snprintf(table->names[i], sizeof(*table->names), "option-%d", i);
+        char shortName = i < (int)sizeof(letters) - 1 ? letters[i] : 0;
+        bool integer = i % 4 == 3;
+        ArgparserOption option = integer
+            ? (ArgparserOption)ARGPARSER_OPT_INT(shortName, table->names[i], &table->integers[i], "integer")
+            : (ArgparserOption)ARGPARSER_OPT_BOOL(shortName, table->names[i], &table->booleans[i], "boolean");
+        memcpy(&table->options[i], &option, sizeof(option));
+
+        table->longOptions[i] = (struct option){ table->names[i], integer ? required_argument : no_argument, NULL, 256 + i };
+        if (shortName) {
+            table->shortOptions[s++] = shortName;
+            if (integer)
+                table->shortOptions[s++] = ':';
+            else
+                table->shortNames[table->shortCount++] = shortName;
+        }
+    }
+    table->shortOptions[s] = '\0';
+}
+
+// Fills argv with `count` elements of the given mix, the strings are stored in `storage`
+static void buildArguments(const Table* table, enum Mix mix, int count, const char** argv, char* storage, uint64_t* seed)
+{
+    argv[0] = "bench";
+    for (int i = 1; i < count; ) {
+        enum Mix kind = mix == MIX_MIXED ? (enum Mix)(bench_random(seed) % MIX_MIXED) : mix;
+        int option = (int)(bench_random(seed) % table->count);
+
+        char* arg = storage;
+        switch (kind) {
+        case MIX_SHORT: {
+            option %= table->count < 51 ? table->count : 51;
+            bool integer = option % 4 == 3;
+            storage += sprintf(storage, "-%c", table->options[option].shortName) + 1;
+            if (integer && i + 1 < count) {
+                argv[i++] = arg;
+                arg = storage;
+                storage += sprintf(storage, "%d", (int)(bench_random(seed) % 1000)) + 1;
+            } else if (integer) {
+                storage = arg + sprintf(arg, "--%s=1", table->names[option]) + 1;
+            }
+            break;
+        }
+        case MIX_COMPOUND:
+            *storage++ = '-';
+            for (int c = 0; c < 4; c++)
+                *storage++ = table->shortNames[bench_random(seed) % table->shortCount];
+            *storage++ = '\0';
+            break;
+        case MIX_LONG:
+            option -= option % 4 == 3;
+            storage += sprintf(storage, "--%s", table->names[option]) + 1;
+            break;
+        case MIX_VALUE:
+            option = option - option % 4 + 3;
+            if (option < table->count)
+                storage += sprintf(storage, "--%s=%d", table->names[option], (int)(bench_random(seed) % 1000)) + 1;
+            else
+                storage += sprintf(storage, "--%s", table->names[option - 3]) + 1;
+            break;
+        default:
+            storage += sprintf(storage, "file-%d.dat", i) + 1;
+            break;
+        }
+        argv[i++] = arg;
+    }
+    argv[count] = NULL;
+}
+
+static double parseArgparser(const Table* table, int count, const char** arguments, const char** argv,
+    size_t* parseAllocations, int* remaining)
+{
+    Argparser* argparser = Argparser_new();
+    Argparser_init(argparser, table->options);
+
+    int repetitions = count < MIN_ARGUMENTS ? MIN_ARGUMENTS / count : 1;
+    uint64_t ns = 0;
+    bench_allocations = 0;
+    for (int r = 0; r < repetitions; r++) {
+        memcpy(argv, arguments, (count + 1) * sizeof(*argv));   // Parsing reorders argv
+        uint64_t start = bench_nowNs();
+        *remaining = Argparser_parse(argparser, count, argv);
+        ns += bench_nowNs() - start;
+    }
+    *parseAllocations = bench_allocations / repetitions;
+    Argparser_delete(argparser);
+    return (double)ns / repetitions / (count - 1);
+}
+
+static double parseGetopt(const Table* table, int count, const char** arguments, const char** argv, int* remaining)
+{
+    int repetitions = count < MIN_ARGUMENTS ? MIN_ARGUMENTS / count : 1;
+    uint64_t ns = 0;
+    opterr = 0;
+    for (int r = 0; r < repetitions; r++) {
+        memcpy(argv, arguments, (count + 1) * sizeof(*argv));
+        uint64_t start = bench_nowNs();
+        optind = 0;     // Reinitializes glibc's getopt
+        int c;
+        while ((c = getopt_long(count, (char* const*)argv, table->shortOptions, table->longOptions, NULL)) != -1) {
+            // Store the values like Argparser
+            int option = c - 256;
+            if (c == '?' || c == ':') {
+                fprintf(stderr, "getopt_long rejected `%s`\n", argv[optind - 1]);
+                continue;
+            }
+            for (int i = 0; c < 256 && i < table->count && i < 51; i++) {
+                if (table->options[i].shortName == c)
+                    option = i;
+            }
+            if (option % 4 == 3)
+                table->integers[option] = atoi(optarg);
+            else
+                table->booleans[option] = true;
+        }
+        *remaining = count - optind;
+        ns += bench_nowNs() - start;
+    }
+    return (double)ns / repetitions / (count - 1);
+}
+
+static void run(int optionCount, int argumentCount, enum Mix mix)
+{
+    fflush(stdout);
+    pid_t child = fork();
+    if (child != 0) {
+        waitpid(child, NULL, 0);
+        return;
+    }
+
+    uint64_t seed = (uint64_t)optionCount * 31 + argumentCount * 7 + mix + 1;
+    Table table;
+    buildTable(&table, optionCount);
+    const char** arguments = malloc((argumentCount + 1) * sizeof(*arguments));
+    const char** argv = malloc((argumentCount + 1) * sizeof(*argv));
+    char* storage = malloc((size_t)argumentCount * 24);
+    buildArguments(&table, mix, argumentCount, arguments, storage, &seed);
+
+    size_t parseAllocations;
+    int remaining = 0, getoptRemaining = 0;
+    double argparserNs = parseArgparser(&table, argumentCount, arguments, argv, &parseAllocations, &remaining);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("%8d %8d %-10s %12.1f", optionCount, argumentCount, mixNames[mix], argparserNs);
+    if ((double)optionCount * argumentCount <= MAX_GETOPT_WORK
+        && (mix != MIX_MIXED || argumentCount <= MAX_GETOPT_PERMUTED)) {
+        double getoptNs = parseGetopt(&table, argumentCount, arguments, argv, &getoptRemaining);
+        printf(" %12.1f %8.2fx", getoptNs, getoptNs / argparserNs);
+        if (remaining != getoptRemaining)
+            fprintf(stderr, "remaining arguments differ: %d, %d\n", remaining, getoptRemaining);
+    } else {
+        printf(" %12s %9s", "-", "-");
+    }
+    printf(" %12zu %10.1f\n", parseAllocations, usage.ru_maxrss / 1024.0);
+    fflush(stdout);
+    _exit(0);
+}
+
+int main()
+{
+    static const int optionCounts[] = { 10, 100, 1000, 10000, 100000 };
+    static const int argumentCounts[] = { 10, 1000, 100000, 1000000 };
+
+    printf("%8s %8s %-10s %12s %12s %9s %12s %10s\n",
+        "options", "args", "mix", "ns/arg", "getopt ns", "speedup", "allocs/parse", "peak MiB");
+    for (size_t o = 0; o < sizeof(optionCounts) / sizeof(*optionCounts); o++)
+        run(optionCounts[o], 100000, MIX_LONG);
+    for (size_t a = 0; a < sizeof(argumentCounts) / sizeof(*argumentCounts); a++) {
+        for (int mix = 0; mix < MIX_COUNT; mix++)
+            run(100, argumentCounts[a], (enum Mix)mix);
+    }
+    return 0;
+}
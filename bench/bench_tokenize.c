@@ -0,0 +1,62 @@
+/**
+ * Measures the throughput of `Argparser_tokenize` on multi-megabyte command lines.
+ */
+#define _POSIX_C_SOURCE 200809L
+#define ARGPARSER_IMPLEMENTATION
+#include "../Argparser.h"
+#include "bench.h"
+
+#define INPUT_SIZE (16u << 20)
+#define RUNS 5
+
+static const char* fragments[] = {
+    "--verbose ", "-cAs7 ", "--number=42 ", "-p 0.5 ", "/usr/local/include/some/header.h ",
+    "'single quoted argument' ", "\"double \\\"quoted\\\" $HOME\" ", "escaped\\ space ",
+    "--define=NAME=\"value with spaces\" ", "\t", "\n",
+};
+
+int main()
+{
+    uint64_t seed = 7;
+    char* input = malloc(INPUT_SIZE + 64);
+    size_t length = 0;
+    while (length < INPUT_SIZE) {
+        const char* fragment = fragments[bench_random(&seed) % (sizeof(fragments) / sizeof(*fragments))];
+        size_t size = strlen(fragment);
+        memcpy(input + length, fragment, size);
+        length += size;
+    }
+
+    char* arena = malloc(length + 1);
+    int count = Argparser_tokenize(input, length, arena, NULL, 0);
+    const char** argv = malloc((count + 1) * sizeof(*argv));
+    char* copy = malloc(length + 1);
+
+    uint64_t separate = UINT64_MAX;
+    uint64_t inPlace = UINT64_MAX;
+    for (int run = 0; run < RUNS; run++) {
+        uint64_t start = bench_nowNs();
+        if (Argparser_tokenize(input, length, arena, argv, count + 1) != count)
+            fprintf(stderr, "unexpected token count\n");
+        uint64_t elapsed = bench_nowNs() - start;
+        separate = elapsed < separate ? elapsed : separate;
+
+        memcpy(copy, input, length);
+        start = bench_nowNs();
+        if (Argparser_tokenize(copy, length, copy, argv, count + 1) != count)
+            fprintf(stderr, "unexpected token count\n");
+        elapsed = bench_nowNs() - start;
+        inPlace = elapsed < inPlace ? elapsed : inPlace;
+    }
+
+    double megabytes = length / (1024.0 * 1024.0);
+    printf("input: %.1f MiB, %d arguments\n", megabytes, count);
+    printf("%-10s %10.1f MiB/s %8.2f ns/arg\n", "arena", megabytes / (separate / 1e9), (double)separate / count);
+    printf("%-10s %10.1f MiB/s %8.2f ns/arg\n", "in place", megabytes / (inPlace / 1e9), (double)inPlace / count);
+
+    free(copy);
+    free(argv);
+    free(arena);
+    free(input);
+    return 0;
+}
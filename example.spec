@@ -0,0 +1,18 @@
+# Options of example.c as a spec for tools/argparser_gen.c
+name        Example
+usage       example [options] [[--] args
+description Optional brief description of what the program does and how it works.
+epilog      Optional description of the program after the description of the arguments.
+
+group   Basic Options
+help    h   help        -                   show this help message and exit
+bool    c   check       check               example for a boolean
+int     n   number      number              example for an integer
+float   p   percent     percent             example for a float
+string  l   lastname    lastname            example for a string
+
+group   More Options
+bool    A   UpperChars  upperCharacters     example with upper characters
+bool    -   no-short    noShort             example without short name
+bool    s   -           noLong              example with no long name
+bool    7   seven77     numeric             example with numeric names
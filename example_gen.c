@@ -0,0 +1,34 @@
+#define ARGPARSER_IMPLEMENTATION
+#include "Argparser.h"
+#include "example.gen.h"
+
+int main(int argc, const char **argv)
+{
+    // Values keep their initial value, if the option is not given.
+    ExampleOptions options = {0};
+
+    // Parse arguments with the parser generated from example.spec
+    argc = Example_parse(&options, argc, argv, NULL);
+
+    // Print all values
+    printf("\n");
+    printf("Boolean (-c / --check):    %d\n", options.check);
+    printf("Integer (-n / --number):   %d\n", options.number);
+    printf("Float   (-p / --percent):  %f\n", options.percent);
+    printf("String  (-l / --lastname): %s\n", options.lastname);
+    printf("\n");
+    printf("Upper Characters (-A / --UpperChars): %d\n", options.upperCharacters);
+    printf("No Short Name    (     --no-short):   %d\n", options.noShort);
+    printf("No Long Name     (-s):                %d\n", options.noLong);
+    printf("Numeric Names    (-7 / --seven77):    %d\n", options.numeric);
+    printf("\n");
+
+    // Print remaining arguments
+    if (argc != 0) {
+        printf("argc: %d\n", argc);
+        for (int i = 0; i < argc; i++) {
+            printf("argv[%d]: %s\n", i, *(argv + i));
+        }
+    }
+    return 0;
+}
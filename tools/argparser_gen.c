@@ -0,0 +1,716 @@
+/**
+ * argparser_gen.c
+ *
+ * Generates a specialized parser from an option spec, as an alternative to
+ * interpreting an `ArgparserOption` array at runtime. The output is a header
+ * with an options struct, the rendered help message, and a parse function
+ * that matches names with nested `switch` statements and stores values
+ * directly into the struct. It uses the conversions and `ArgparserError` of
+ * Argparser.h, whose implementation has to be compiled into the program.
+ *
+ * Usage: argparser_gen <spec> <output.h>
+ *
+ * Spec lines, `#` starts a comment:
+ *     name <Name>                  Prefix of the generated struct `<Name>Options` and functions
+ *     usage <text>
+ *     description <text>
+ *     epilog <text>
+ *     stop-at-non-option
+ *     group <text>
+ *     <type> <short> <long> <field> <help text>
+ * Types are help, bool, int, float, string, int64, uint64, double, and size.
+ * A `-` stands for no short name, no long name, or no field (only for help).
+ */
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_OPTIONS 1024
+#define MAX_LINE    4096
+
+typedef struct Type
+{
+    const char *name;
+    const char *cType;          // NULL for help
+    const char *hint;           // Placeholder in the help message
+    const char *conversion;     // Stores `value` into `options->field`, NULL if handled separately
+} Type;
+
+static const Type types[] = {
+    { "help",   NULL,           "",             NULL },
+    { "bool",   "bool",         "",             NULL },
+    { "int",    "int",          "=<int>",       "reason = %s_toInt(value, &options->%s);" },
+    { "float",  "float",        "=<float>",     "reason = %s_toFloat(value, &options->%s);" },
+    { "string", "const char *", "=<string>",    NULL },
+    { "int64",  "int64_t",      "=<int64>",     "reason = %.0sArgparser_toInt64(value, &options->%s);" },
+    { "uint64", "uint64_t",     "=<uint64>",    "reason = %.0sArgparser_toUint64(value, &options->%s);" },
+    { "double", "double",       "=<double>",    "reason = %.0sArgparser_toDouble(value, &options->%s);" },
+    { "size",   "size_t",       "=<size>",      "reason = %.0sArgparser_toSize(value, &options->%s);" },
+};
+
+typedef struct Option
+{
+    const Type *type;           // NULL for groups
+    char shortName;
+    char *longName;
+    char *field;
+    char *help;
+} Option;
+
+typedef struct Spec
+{
+    char *name;
+    char *usage;
+    char *description;
+    char *epilog;
+    bool stopAtNonOption;
+    Option options[MAX_OPTIONS];
+    int count;
+} Spec;
+
+// Trie of the long names, emitted as nested switch statements
+typedef struct Node
+{
+    char character;
+    int option;                 // Index of the option ending here, or -1
+    struct Node *children;
+    struct Node *next;
+} Node;
+
+static const char *specPath;
+static int specLine;
+
+static void fail(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%s:%d: error: ", specPath, specLine);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+    exit(1);
+}
+
+static char *duplicate(const char *text)
+{
+    size_t length = strlen(text) + 1;
+    return memcpy(malloc(length), text, length);
+}
+
+// Splits off the next word, returns NULL at the end of the line
+static char *nextWord(char **line)
+{
+    char *word = *line + strspn(*line, " \t");
+    if (!*word)
+        return NULL;
+    char *end = word + strcspn(word, " \t");
+    *line = *end ? end + 1 : end;
+    *end = '\0';
+    return word;
+}
+
+static char *restOfLine(char *line)
+{
+    line += strspn(line, " \t");
+    return duplicate(line);
+}
+
+static bool isIdentifier(const char *text)
+{
+    if (!((*text >= 'a' && *text <= 'z') || (*text >= 'A' && *text <= 'Z') || *text == '_'))
+        return false;
+    for (; *text; text++) {
+        if (!((*text >= 'a' && *text <= 'z') || (*text >= 'A' && *text <= 'Z')
+            || (*text >= '0' && *text <= '9') || *text == '_'))
+            return false;
+    }
+    return true;
+}
+
+static void parseOption(Spec *spec, const Type *type, char *line)
+{
+    char *shortName = nextWord(&line);
+    char *longName = nextWord(&line);
+    char *field = nextWord(&line);
+    if (!field)
+        fail("expected `%s <short> <long> <field> <help>`", type->name);
+    if (spec->count == MAX_OPTIONS)
+        fail("more than %d options", MAX_OPTIONS);
+
+    Option *option = &spec->options[spec->count];
+    option->type = type;
+    if (strcmp(shortName, "-") != 0) {
+        if (shortName[1] || shortName[0] == '-' || shortName[0] == '=')
+            fail("short name `%s` is not a single character", shortName);
+        option->shortName = shortName[0];
+    }
+    if (strcmp(longName, "-") != 0) {
+        if (strchr(longName, '='))
+            fail("long name `%s` contains `=`", longName);
+        option->longName = duplicate(longName);
+    }
+    if (!option->shortName && !option->longName)
+        fail("option needs a short or a long name");
+    if (strcmp(field, "-") != 0) {
+        if (!isIdentifier(field))
+            fail("field `%s` is not a C identifier", field);
+        option->field = duplicate(field);
+    } else if (type->cType) {
+        fail("%s option needs a field", type->name);
+    }
+    option->help = restOfLine(line);
+
+    for (int i = 0; i < spec->count; i++) {
+        const Option *other = &spec->options[i];
+        if (!other->type)
+            continue;
+        if (option->shortName && other->shortName == option->shortName)
+            fail("option `-%c` is defined more than once", option->shortName);
+        if (option->longName && other->longName && strcmp(other->longName, option->longName) == 0)
+            fail("option `--%s` is defined more than once", option->longName);
+        if (option->field && other->field && strcmp(other->field, option->field) == 0)
+            fail("field `%s` is used more than once", option->field);
+    }
+    spec->count++;
+}
+
+static void parseSpec(Spec *spec, FILE *file)
+{
+    char buffer[MAX_LINE];
+    while (fgets(buffer, sizeof(buffer), file)) {
+        specLine++;
+        buffer[strcspn(buffer, "\r\n")] = '\0';
+        char *line = buffer;
+        char *keyword = nextWord(&line);
+        if (!keyword || keyword[0] == '#')
+            continue;
+
+        if (strcmp(keyword, "name") == 0) {
+            char *name = nextWord(&line);
+            if (!name || !isIdentifier(name))
+                fail("expected `name <identifier>`");
+            spec->name = duplicate(name);
+        } else if (strcmp(keyword, "usage") == 0) {
+            spec->usage = restOfLine(line);
+        } else if (strcmp(keyword, "description") == 0) {
+            spec->description = restOfLine(line);
+        } else if (strcmp(keyword, "epilog") == 0) {
+            spec->epilog = restOfLine(line);
+        } else if (strcmp(keyword, "stop-at-non-option") == 0) {
+            spec->stopAtNonOption = true;
+        } else if (strcmp(keyword, "group") == 0) {
+            if (spec->count == MAX_OPTIONS)
+                fail("more than %d options", MAX_OPTIONS);
+            spec->options[spec->count++].help = restOfLine(line);
+        } else {
+            size_t t = 0;
+            while (t < sizeof(types) / sizeof(*types) && strcmp(types[t].name, keyword) != 0)
+                t++;
+            if (t == sizeof(types) / sizeof(*types))
+                fail("unknown keyword or type `%s`", keyword);
+            parseOption(spec, &types[t], line);
+        }
+    }
+    specLine = 0;
+    if (!spec->name)
+        fail("missing `name`");
+}
+
+//******************************************************************************
+// Output
+//******************************************************************************
+static FILE *out;
+
+static void indent(int level)
+{
+    fprintf(out, "%*s", 4 * level, "");
+}
+
+// Writes the text as a C string literal, breaking it after newlines
+static void writeLiteral(const char *text, int level)
+{
+    indent(level);
+    fputc('"', out);
+    for (; *text; text++) {
+        switch (*text) {
+        case '"':   fputs("\\\"", out); break;
+        case '\\':  fputs("\\\\", out); break;
+        case '\t':  fputs("\\t", out); break;
+        case '\n':
+            fputs("\\n\"", out);
+            if (text[1]) {
+                fputc('\n', out);
+                indent(level);
+                fputc('"', out);
+            }
+            break;
+        default:    fputc(*text, out); break;
+        }
+    }
+    if (text[-1] != '\n')
+        fputc('"', out);
+}
+
+static void append(char **text, size_t *length, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    size_t needed = (size_t)vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    *text = realloc(*text, *length + needed + 1);
+    va_start(args, format);
+    vsnprintf(*text + *length, needed + 1, format, args);
+    va_end(args);
+    *length += needed;
+}
+
+// Same layout as Argparser_renderHelp without wrapping
+static char *renderHelp(const Spec *spec)
+{
+    char *text = NULL;
+    size_t length = 0;
+    append(&text, &length, "");
+    if (spec->usage)
+        append(&text, &length, "Usage: %s\n", spec->usage);
+    if (spec->description)
+        append(&text, &length, "%s\n", spec->description);
+
+    size_t width = 0;
+    for (int i = 0; i < spec->count; i++) {
+        const Option *option = &spec->options[i];
+        if (!option->type)
+            continue;
+        size_t len = (option->shortName ? 2 : 0) + (option->shortName && option->longName ? 2 : 0)
+            + (option->longName ? strlen(option->longName) + 2 : 0) + strlen(option->type->hint);
+        len = (len + 3) - ((len + 3) & 3);
+        if (width < len)
+            width = len;
+    }
+    width += 4;
+
+    for (int i = 0; i < spec->count; i++) {
+        const Option *option = &spec->options[i];
+        if (!option->type) {
+            append(&text, &length, "\n%s\n", option->help);
+            continue;
+        }
+        size_t start = length;
+        append(&text, &length, "    ");
+        if (option->shortName)
+            append(&text, &length, "-%c", option->shortName);
+        if (option->shortName && option->longName)
+            append(&text, &length, ", ");
+        if (option->longName)
+            append(&text, &length, "--%s", option->longName);
+        append(&text, &length, "%s", option->type->hint);
+
+        size_t pos = length - start;
+        if (pos <= width)
+            append(&text, &length, "%*s%s\n", (int)(width - pos + 2), "", option->help);
+        else
+            append(&text, &length, "\n%*s%s\n", (int)(width + 2), "", option->help);
+    }
+
+    if (spec->epilog)
+        append(&text, &length, "\n%s\n", spec->epilog);
+    return text;
+}
+
+// Name as used in error messages of Argparser.h
+static void writeDisplayName(const Option *option)
+{
+    if (option->shortName && option->longName)
+        fprintf(out, "`-%c`/`--%s`", option->shortName, option->longName);
+    else if (option->shortName)
+        fprintf(out, "`-%c`", option->shortName);
+    else
+        fprintf(out, "`--%s`", option->longName);
+}
+
+// Writes the display name as a C string literal for error messages
+static void writeDisplayLiteral(const Option *option)
+{
+    char text[MAX_LINE + 16];
+    if (option->shortName && option->longName)
+        snprintf(text, sizeof(text), "`-%c`/`--%s`", option->shortName, option->longName);
+    else if (option->shortName)
+        snprintf(text, sizeof(text), "`-%c`", option->shortName);
+    else
+        snprintf(text, sizeof(text), "`--%s`", option->longName);
+    writeLiteral(text, 0);
+}
+
+static void writeCharacter(char c)
+{
+    if (c == '\'' || c == '\\')
+        fprintf(out, "'\\%c'", c);
+    else
+        fprintf(out, "'%c'", c);
+}
+
+static void insertName(Node *root, const char *name, int option)
+{
+    Node *node = root;
+    for (; *name; name++) {
+        Node **child = &node->children;
+        while (*child && (*child)->character != *name)
+            child = &(*child)->next;
+        if (!*child) {
+            *child = calloc(1, sizeof(Node));
+            (*child)->character = *name;
+            (*child)->option = -1;
+        }
+        node = *child;
+    }
+    node->option = option;
+}
+
+static void writeLongLeaf(const Spec *spec, int o, int depth, int level)
+{
+    const Option *option = &spec->options[o];
+    fprintf(out, "\n");
+    indent(level);
+    fprintf(out, "case '\\0': case '=':\n");
+    if (option->type->conversion || strcmp(option->type->name, "string") == 0) {
+        // Like Argparser.h, only booleans may omit the value of long options
+        indent(level + 1);
+        fprintf(out, "if (!name[%d])\n", depth);
+        indent(level + 2);
+        fprintf(out, "goto unknown;\n");
+        indent(level + 1);
+        fprintf(out, "value = name + %d;\n", depth + 1);
+    } else {
+        indent(level + 1);
+        fprintf(out, "value = name[%d] ? name + %d : NULL;\n", depth, depth + 1);
+    }
+    indent(level + 1);
+    fprintf(out, "goto option%d;\n", o);
+}
+
+static void writeNode(const Spec *spec, const Node *node, int depth, int level)
+{
+    // Chains without branches are compared at once
+    char run[MAX_LINE];
+    int length = 0;
+    while (node->option < 0 && node->children && !node->children->next) {
+        node = node->children;
+        run[length++] = node->character;
+    }
+    if (length > 0) {
+        run[length] = '\0';
+        indent(level);
+        fprintf(out, "if (strncmp(name + %d, ", depth);
+        writeLiteral(run, 0);
+        fprintf(out, ", %d) == 0) {\n", length);
+        depth += length;
+        level++;
+    }
+
+    indent(level);
+    fprintf(out, "switch (name[%d]) {", depth);
+    if (node->option >= 0)
+        writeLongLeaf(spec, node->option, depth, level);
+    for (const Node *child = node->children; child; child = child->next) {
+        fprintf(out, "\n");
+        indent(level);
+        fprintf(out, "case ");
+        writeCharacter(child->character);
+        fprintf(out, ":\n");
+        writeNode(spec, child, depth + 1, level + 1);
+        indent(level + 1);
+        fprintf(out, "break;\n");
+    }
+    indent(level);
+    fprintf(out, "}\n");
+
+    if (length > 0) {
+        indent(level - 1);
+        fprintf(out, "}\n");
+    }
+}
+
+static void writeHandler(const Spec *spec, int o)
+{
+    const Option *option = &spec->options[o];
+    const char *type = option->type->name;
+    const char *name = spec->name;
+    fprintf(out, "\n    option%d:    // ", o);
+    writeDisplayName(option);
+    fprintf(out, "\n");
+
+    if (strcmp(type, "help") == 0) {
+        fprintf(out, "        if (!error) {\n");
+        fprintf(out, "            fwrite(%s_help, 1, sizeof(%s_help) - 1, stdout);\n", name, name);
+        fprintf(out, "            exit(0);\n");
+        fprintf(out, "        }\n");
+        fprintf(out, "        return %s_fail(error, ARGPARSER_ERROR_HELP, at, \"help requested\");\n", name);
+        return;
+    }
+
+    if (strcmp(type, "bool") == 0) {
+        fprintf(out, "        if (!value || (value[0] == '1' && !value[1]))\n");
+        fprintf(out, "            options->%s = true;\n", option->field);
+        fprintf(out, "        else if (value[0] == '0' && !value[1])\n");
+        fprintf(out, "            options->%s = false;\n", option->field);
+        fprintf(out, "        else\n");
+        fprintf(out, "            reason = \"expects no value, 0, or 1\";\n");
+    } else {
+        fprintf(out, "        if (!value)\n");
+        fprintf(out, "            reason = \"requires a value\";\n");
+        if (strcmp(type, "string") == 0) {
+            fprintf(out, "        else\n");
+            fprintf(out, "            options->%s = value;\n", option->field);
+        } else {
+            fprintf(out, "        else\n");
+            fprintf(out, "            ");
+            fprintf(out, option->type->conversion, name, option->field);
+            fprintf(out, "\n");
+        }
+    }
+    fprintf(out, "        if (reason)\n");
+    fprintf(out, "            return %s_fail(error, ARGPARSER_ERROR_INVALID_VALUE, at, \"option %%s %%s\", ", name);
+    writeDisplayLiteral(option);
+    fprintf(out, ", reason);\n");
+    fprintf(out, "        continue;\n");
+}
+
+static void writeParser(const Spec *spec, const char *source)
+{
+    const char *name = spec->name;
+    bool hasInt = false, hasFloat = false;
+    for (int i = 0; i < spec->count; i++) {
+        if (spec->options[i].type) {
+            hasInt |= strcmp(spec->options[i].type->name, "int") == 0;
+            hasFloat |= strcmp(spec->options[i].type->name, "float") == 0;
+        }
+    }
+
+    fprintf(out, "// Generated by argparser_gen from %s, do not edit.\n", source);
+    fprintf(out, "// Requires Argparser.h and its implementation in the program.\n");
+    fprintf(out, "#pragma once\n");
+    fprintf(out, "#include <limits.h>\n");
+    fprintf(out, "#include <math.h>\n");
+    fprintf(out, "#include <stdarg.h>\n");
+    fprintf(out, "#include <stdio.h>\n");
+    fprintf(out, "#include <stdlib.h>\n");
+    fprintf(out, "#include <string.h>\n\n");
+
+    // Options struct
+    fprintf(out, "typedef struct %sOptions\n{\n", name);
+    for (int i = 0; i < spec->count; i++) {
+        const Option *option = &spec->options[i];
+        if (!option->type || !option->type->cType)
+            continue;
+        const char *cType = option->type->cType;
+        int length = fprintf(out, "    %s%s%s;", cType, cType[strlen(cType) - 1] == '*' ? "" : " ", option->field);
+        fprintf(out, "%*s// ", length < 30 ? 30 - length : 1, "");
+        writeDisplayName(option);
+        fprintf(out, "\n");
+    }
+    fprintf(out, "} %sOptions;\n\n", name);
+
+    // Help message
+    char *help = renderHelp(spec);
+    fprintf(out, "static const char %s_help[] =\n", name);
+    if (*help)
+        writeLiteral(help, 1);
+    else
+        fprintf(out, "    \"\"");
+    fprintf(out, ";\n\n");
+    free(help);
+
+    // Error handling like Argparser_fail
+    fprintf(out, "static int %s_fail(ArgparserError* error, enum ArgparserErrorCode code, int index, const char* format, ...)\n", name);
+    fprintf(out, "{\n");
+    fprintf(out, "    va_list args;\n");
+    fprintf(out, "    va_start(args, format);\n");
+    fprintf(out, "    if (!error) {\n");
+    fprintf(out, "        fprintf(stderr, \"error: \");\n");
+    fprintf(out, "        vfprintf(stderr, format, args);\n");
+    fprintf(out, "        fputc('\\n', stderr);\n");
+    fprintf(out, "        if (code == ARGPARSER_ERROR_UNKNOWN_OPTION)\n");
+    fprintf(out, "            fwrite(%s_help, 1, sizeof(%s_help) - 1, stdout);\n", name, name);
+    fprintf(out, "        exit(1);\n");
+    fprintf(out, "    }\n");
+    fprintf(out, "    error->code = code;\n");
+    fprintf(out, "    error->index = index;\n");
+    fprintf(out, "    error->option = NULL;\n");
+    fprintf(out, "    if (error->message && error->messageSize)\n");
+    fprintf(out, "        vsnprintf(error->message, error->messageSize, format, args);\n");
+    fprintf(out, "    va_end(args);\n");
+    fprintf(out, "    return -1;\n");
+    fprintf(out, "}\n\n");
+
+    if (hasInt) {
+        fprintf(out, "static const char* %s_toInt(const char* text, int* value)\n", name);
+        fprintf(out, "{\n");
+        fprintf(out, "    int64_t number;\n");
+        fprintf(out, "    const char* reason = Argparser_toInt64(text, &number);\n");
+        fprintf(out, "    if (!reason && (number < INT_MIN || number > INT_MAX))\n");
+        fprintf(out, "        reason = \"value out of range\";\n");
+        fprintf(out, "    if (!reason)\n");
+        fprintf(out, "        *value = (int)number;\n");
+        fprintf(out, "    return reason;\n");
+        fprintf(out, "}\n\n");
+    }
+    if (hasFloat) {
+        fprintf(out, "static const char* %s_toFloat(const char* text, float* value)\n", name);
+        fprintf(out, "{\n");
+        fprintf(out, "    double number;\n");
+        fprintf(out, "    const char* reason = Argparser_toDouble(text, &number);\n");
+        fprintf(out, "    if (!reason && isfinite(number) && isinf((float)number))\n");
+        fprintf(out, "        reason = \"value out of range\";\n");
+        fprintf(out, "    if (!reason)\n");
+        fprintf(out, "        *value = (float)number;\n");
+        fprintf(out, "    return reason;\n");
+        fprintf(out, "}\n\n");
+    }
+
+    // Parse function
+    fprintf(out, "/**\n");
+    fprintf(out, " * Parses the arguments into `options` like `Argparser_tryParse()`, returns the amount of remaining arguments.\n");
+    fprintf(out, " * The remaining arguments are moved to the front of argv.\n");
+    fprintf(out, " * Without `error`, errors are printed and exit the program; `error->option` is always NULL.\n");
+    fprintf(out, " */\n");
+    fprintf(out, "static int %s_parse(%sOptions* options, int argc, const char** argv, ArgparserError* error)\n", name, name);
+    fprintf(out, "{\n");
+    fprintf(out, "    if (error) {\n");
+    fprintf(out, "        error->code = ARGPARSER_OK;\n");
+    fprintf(out, "        error->index = -1;\n");
+    fprintf(out, "        error->option = NULL;\n");
+    fprintf(out, "        if (error->message && error->messageSize)\n");
+    fprintf(out, "            error->message[0] = '\\0';\n");
+    fprintf(out, "    }\n\n");
+    fprintf(out, "    int kept = 0;\n");
+    fprintf(out, "    int i = 1;\n");
+    fprintf(out, "    for (; i < argc; i++) {\n");
+    fprintf(out, "        const char* arg = argv[i];\n");
+    fprintf(out, "        const char* value = NULL;\n");
+    fprintf(out, "        const char* reason = NULL;\n");
+    fprintf(out, "        int at = i;\n");
+    fprintf(out, "        (void)reason;\n");
+    fprintf(out, "        if (arg[0] != '-' || !arg[1]) {\n");
+    if (spec->stopAtNonOption)
+        fprintf(out, "            break;\n");
+    else
+        fprintf(out, "            argv[kept++] = arg;\n            continue;\n");
+    fprintf(out, "        }\n\n");
+
+    // Long options
+    fprintf(out, "        if (arg[1] == '-') {\n");
+    fprintf(out, "            if (!arg[2]) {\n");
+    fprintf(out, "                i++;\n");
+    fprintf(out, "                break;\n");
+    fprintf(out, "            }\n");
+    Node root = { 0, -1, NULL, NULL };
+    for (int o = 0; o < spec->count; o++) {
+        if (spec->options[o].type && spec->options[o].longName)
+            insertName(&root, spec->options[o].longName, o);
+    }
+    if (root.children) {
+        fprintf(out, "            const char* name = arg + 2;\n");
+        writeNode(spec, &root, 0, 3);
+    }
+    fprintf(out, "            goto unknown;\n");
+    fprintf(out, "        }\n\n");
+
+    // Bundled short options are booleans without values
+    fprintf(out, "        if (arg[2]) {\n");
+    fprintf(out, "            for (const char* c = arg + 1; *c; c++) {\n");
+    fprintf(out, "                switch (*c) {\n");
+    for (int o = 0; o < spec->count; o++) {
+        const Option *option = &spec->options[o];
+        if (!option->type || !option->shortName)
+            continue;
+        fprintf(out, "                case ");
+        writeCharacter(option->shortName);
+        fprintf(out, ":\n");
+        if (strcmp(option->type->name, "bool") == 0) {
+            fprintf(out, "                    options->%s = true;\n", option->field);
+            fprintf(out, "                    break;\n");
+        } else if (strcmp(option->type->name, "help") == 0) {
+            fprintf(out, "                    goto option%d;\n", o);
+        } else {
+            fprintf(out, "                    return %s_fail(error, ARGPARSER_ERROR_INVALID_VALUE, at, \"option %%s requires a value\", ", name);
+            writeDisplayLiteral(option);
+            fprintf(out, ");\n");
+        }
+    }
+    fprintf(out, "                default:\n");
+    fprintf(out, "                    goto unknown;\n");
+    fprintf(out, "                }\n");
+    fprintf(out, "            }\n");
+    fprintf(out, "            continue;\n");
+    fprintf(out, "        }\n\n");
+
+    // Single short options take the next argument as value, unless it is an option.
+    // Booleans only take 0 and 1, and true and false to reject them, so `-v file` passes `file` on.
+    fprintf(out, "        switch (arg[1]) {\n");
+    for (int o = 0; o < spec->count; o++) {
+        const Option *option = &spec->options[o];
+        if (!option->type || !option->shortName)
+            continue;
+        fprintf(out, "        case ");
+        writeCharacter(option->shortName);
+        fprintf(out, ":\n");
+        if (strcmp(option->type->name, "bool") == 0) {
+            fprintf(out, "            if (i + 1 < argc && argv[i + 1] && (strcmp(argv[i + 1], \"0\") == 0\n");
+            fprintf(out, "                || strcmp(argv[i + 1], \"1\") == 0 || strcmp(argv[i + 1], \"true\") == 0\n");
+            fprintf(out, "                || strcmp(argv[i + 1], \"false\") == 0))\n");
+            fprintf(out, "                value = argv[++i];\n");
+        } else if (strcmp(option->type->name, "help") != 0) {
+            fprintf(out, "            if (i + 1 < argc && argv[i + 1] && argv[i + 1][0] != '-')\n");
+            fprintf(out, "                value = argv[++i];\n");
+        }
+        fprintf(out, "            goto option%d;\n", o);
+    }
+    fprintf(out, "        default:\n");
+    fprintf(out, "            goto unknown;\n");
+    fprintf(out, "        }\n");
+
+    // Value handlers, shared by short and long names
+    for (int o = 0; o < spec->count; o++) {
+        if (spec->options[o].type)
+            writeHandler(spec, o);
+    }
+    fprintf(out, "\n    unknown:\n");
+    fprintf(out, "        return %s_fail(error, ARGPARSER_ERROR_UNKNOWN_OPTION, at, \"unknown option `%%s`\", argv[at]);\n", name);
+    fprintf(out, "    }\n\n");
+
+    fprintf(out, "    memmove(argv + kept, argv + i, (argc - i) * sizeof(*argv));\n");
+    fprintf(out, "    argv[kept + argc - i] = NULL;\n");
+    fprintf(out, "    return kept + argc - i;\n");
+    fprintf(out, "}\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <spec> <output.h>\n", argv[0]);
+        return 1;
+    }
+    specPath = argv[1];
+    FILE *file = fopen(specPath, "r");
+    if (!file) {
+        fprintf(stderr, "error: cannot open `%s`\n", specPath);
+        return 1;
+    }
+    static Spec spec;
+    parseSpec(&spec, file);
+    fclose(file);
+
+    out = fopen(argv[2], "w");
+    if (!out) {
+        fprintf(stderr, "error: cannot write `%s`\n", argv[2]);
+        return 1;
+    }
+    const char *source = strrchr(specPath, '/');
+    writeParser(&spec, source ? source + 1 : specPath);
+    if (fclose(out) != 0) {
+        fprintf(stderr, "error: cannot write `%s`\n", argv[2]);
+        return 1;
+    }
+    return 0;
+}